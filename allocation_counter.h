@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace figfit
+{
+
+/**
+ * @brief Number of heap allocations made by the program
+ *
+ * Counted only in programs which define FIGFIT_COUNT_ALLOCATIONS before
+ * including this header in exactly one translation unit, otherwise it stays
+ * zero.
+ */
+inline std::atomic<size_t> allocation_count(0);
+
+/**
+ * @class AllocationCounter allocation_counter.h
+ *
+ * @brief Counter of heap allocations made since its construction
+ *
+ * Meant for tests and benchmarks checking that hot paths, e.g. fits with a
+ * warmed-up FitWorkspace, do not allocate. Allocations of all threads are
+ * counted.
+ */
+class AllocationCounter
+{
+public:
+
+  /**
+   * @brief Construction (starts counting)
+   */
+  AllocationCounter() :
+    start_(allocation_count.load())
+  {}
+
+  /**
+   * @brief Restart counting
+   */
+  void reset() {
+    start_ = allocation_count.load();
+  }
+
+  /**
+   * @brief Get number of allocations since construction or reset
+   */
+  size_t allocations() const {
+    return allocation_count.load() - start_;
+  }
+
+  /**
+   * @brief Check if allocations are counted in this program
+   */
+  static bool isEnabled() {
+#ifdef FIGFIT_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+  }
+
+private:
+
+  size_t start_;  /**< @brief Count at construction or reset */
+};
+
+} // end namespace figfit
+
+#ifdef FIGFIT_COUNT_ALLOCATIONS
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#ifdef __GLIBC__
+
+// Counting the malloc family catches the allocations of operator new as well
+// as these done by Armadillo directly
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) {
+  figfit::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  figfit::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+  figfit::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(p, size);
+}
+
+int posix_memalign(void** p, size_t alignment, size_t size) {
+  figfit::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  *p = __libc_memalign(alignment, size);
+  return *p ? 0 : ENOMEM;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  figfit::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_memalign(alignment, size);
+}
+}
+
+#else
+
+void* operator new(size_t size) {
+  figfit::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+#endif
+
+#endif // FIGFIT_COUNT_ALLOCATIONS
@@ -0,0 +1,685 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define FIGFIT_COUNT_ALLOCATIONS
+#include "../allocation_counter.h"
+#include "../clustering.h"
+#include "../figure_fitter.h"
+#include "../frame_arena.h"
+#include "../kernels.h"
+#include "../point_cloud.h"
+#include "../polyline_simplifier.h"
+#include "../scan_pipeline.h"
+#include "../thread_pool.h"
+#include "../transform.h"
+#include "../workload_generator.h"
+#include "../figures/arc.h"
+#include "../figures/ellipse.h"
+#include "../figures/rectangle.h"
+
+using namespace std;
+using namespace figfit;
+
+/*
+ * Microbenchmarks of the fits of FigureFitter, the queries of figures, the
+ * kernels of each instruction set level supported by the processor and the
+ * operations of Vec, swept over the number of points N for clean and noisy
+ * data. Results are written as JSON with the time per call, the time per
+ * point and the number of heap allocations per call. With
+ * --check-allocations the program instead verifies that the fits made with a
+ * warmed-up FitWorkspace and the ScanPipeline with a ThreadPool do not
+ * allocate.
+ */
+
+//
+// Harness
+//
+
+struct Options
+{
+  double min_time = 0.1;
+  size_t max_n = 1000000;
+  string filter;
+  string output;
+};
+
+struct Measurement
+{
+  string name;
+  string data;
+  size_t n;
+  size_t iterations;
+  double ns_per_call;
+  double allocations_per_call;
+};
+
+Options options;
+vector<Measurement> results;
+volatile double sink;
+
+/*
+ * Calls function in batches of growing size until the minimal time elapses.
+ * Functions which throw on the first call (e.g. too few points for the fit)
+ * are skipped.
+ */
+void measure(const string& name, const string& data, size_t n,
+             const function<void()>& f) {
+  if (!options.filter.empty() && name.find(options.filter) == string::npos)
+    return;
+
+  try {
+    f();
+  }
+  catch (const exception&) {
+    return;
+  }
+
+  size_t iterations = 0;
+  size_t batch = 1;
+  double elapsed = 0.0;
+  AllocationCounter counter;
+
+  while (elapsed < options.min_time) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < batch; ++i)
+      f();
+    elapsed += chrono::duration<double>(chrono::steady_clock::now() -
+                                        start).count();
+    iterations += batch;
+    batch *= 2;
+  }
+
+  size_t allocated = counter.allocations();
+
+  results.push_back(Measurement{name, data, n, iterations,
+                                1e9 * elapsed / iterations,
+                                double(allocated) / iterations});
+  cerr << name << " [" << data << ", N = " << n << "]: "
+       << results.back().ns_per_call / n << " ns/point\n";
+}
+
+//
+// Workloads
+//
+
+const Line line(0.5, -1.0, 1.0);
+const Segment segment(Point(0.0, 1.0), Point(10.0, 6.0));
+const Circle circle(Point(1.0, -2.0), 3.0);
+const Arc arc(Point(1.0, -2.0), 3.0, -M_PI / 2.0, M_PI);
+const Ellipse ellipse(Point(1.0, 1.0), 4.0, 2.0, 0.3);
+const Rectangle rectangle(Point(-1.0, 2.0), 4.0, 2.0, 0.3);
+
+void benchmarkFits(size_t n, const string& data, double noise) {
+  WorkloadGenerator generator(n);
+  PointCloud2D points, lines, circles, ellipses, rectangles;
+  generator.sample(Point(1.0, 2.0), n, NoiseModel(0.1 + noise), points);
+  generator.sample(segment, n, noise, lines);
+  generator.sample(arc, n, noise, circles);
+  generator.sample(ellipse, n, noise, ellipses);
+  generator.sample(rectangle, n, noise, rectangles);
+
+  FigureFitter point_fitter(points);
+  FigureFitter line_fitter(lines);
+  FigureFitter circle_fitter(circles);
+  FigureFitter ellipse_fitter(ellipses);
+  FigureFitter rectangle_fitter(rectangles);
+
+  Point p;
+  Line l;
+  Segment s;
+  Circle c;
+  Ellipse e;
+  Rectangle r;
+  double v;
+
+  measure("FigureFitter::FigureFitter", data, n, [&]() {
+    FigureFitter fitter(lines);
+    sink = fitter.xCoords()(0);
+  });
+
+  FitWorkspace workspace(n);
+  measure("FigureFitter::FigureFitter(workspace)", data, n, [&]() {
+    FigureFitter fitter(lines, workspace);
+    sink = fitter.xCoords()(0);
+  });
+
+  FigureFitter reused;
+  measure("FigureFitter::assign", data, n, [&]() {
+    reused.assign(lines);
+    sink = reused.xCoords()(0);
+  });
+
+  // The fitters cache the moments, hence each call drops them in order to
+  // measure the pass over the points
+  measure("FigureFitter::fitPoint", data, n, [&]() {
+    point_fitter.dropMoments();
+    point_fitter.fitPoint(p);
+  });
+  measure("FigureFitter::fitPoint+variance", data, n, [&]() {
+    point_fitter.dropMoments();
+    point_fitter.fitPoint(p, v);
+  });
+
+  measure("FigureFitter::fitLine", data, n, [&]() {
+    line_fitter.dropMoments();
+    line_fitter.fitLine(l);
+  });
+  measure("FigureFitter::fitLine+variance", data, n, [&]() {
+    line_fitter.dropMoments();
+    line_fitter.fitLine(l, v);
+  });
+  measure("FigureFitter::fitLine(cached)", data, n, [&]() {
+    line_fitter.fitLine(l);
+  });
+
+  measure("FigureFitter::fitSegment", data, n, [&]() {
+    line_fitter.dropMoments();
+    line_fitter.fitSegment(s);
+  });
+  measure("FigureFitter::fitSegment+variance", data, n, [&]() {
+    line_fitter.dropMoments();
+    line_fitter.fitSegment(s, v);
+  });
+  measure("FigureFitter::fitSegment(MinMax)", data, n, [&]() {
+    line_fitter.dropMoments();
+    line_fitter.fitSegment(s, SegmentExtent::MinMax);
+  });
+  measure("FigureFitter::fitSegment(MinMax)+variance", data, n, [&]() {
+    line_fitter.dropMoments();
+    line_fitter.fitSegment(s, v, SegmentExtent::MinMax);
+  });
+  measure("FigureFitter::fitSegment(Trimmed)", data, n, [&]() {
+    line_fitter.dropMoments();
+    line_fitter.fitSegment(s, SegmentExtent::Trimmed);
+  });
+  measure("FigureFitter::fitSegment(Trimmed)+variance", data, n, [&]() {
+    line_fitter.dropMoments();
+    line_fitter.fitSegment(s, v, SegmentExtent::Trimmed);
+  });
+
+  measure("FigureFitter::fitCircle", data, n, [&]() {
+    circle_fitter.dropMoments();
+    circle_fitter.fitCircle(c);
+  });
+  measure("FigureFitter::fitCircle+variance", data, n, [&]() {
+    circle_fitter.dropMoments();
+    circle_fitter.fitCircle(c, v);
+  });
+  measure("FigureFitter::fitCircle(cached)", data, n, [&]() {
+    circle_fitter.fitCircle(c);
+  });
+  measure("FigureFitter::fitCircleOfRadius", data, n, [&]() {
+    circle_fitter.dropMoments();
+    circle_fitter.fitCircleOfRadius(c, circle.radius());
+  });
+  measure("FigureFitter::fitCircleOfRadius+variance", data, n, [&]() {
+    circle_fitter.dropMoments();
+    circle_fitter.fitCircleOfRadius(c, circle.radius(), v);
+  });
+  measure("FigureFitter::fitCircleOfRadiusRobust", data, n, [&]() {
+    circle_fitter.dropMoments();
+    circle_fitter.fitCircleOfRadiusRobust(c, circle.radius(), 0.1);
+  });
+  measure("FigureFitter::fitCircleOfRadiusRobust+variance", data, n, [&]() {
+    circle_fitter.dropMoments();
+    circle_fitter.fitCircleOfRadiusRobust(c, circle.radius(), 0.1, v);
+  });
+
+  measure("FigureFitter::fitEllipse", data, n, [&]() {
+    ellipse_fitter.dropMoments();
+    ellipse_fitter.fitEllipse(e);
+  });
+  measure("FigureFitter::fitEllipse+variance", data, n, [&]() {
+    ellipse_fitter.dropMoments();
+    ellipse_fitter.fitEllipse(e, v);
+  });
+
+  measure("FigureFitter::fitRectangle", data, n, [&]() {
+    rectangle_fitter.dropMoments();
+    rectangle_fitter.fitRectangle(r);
+  });
+  measure("FigureFitter::fitRectangle+variance", data, n, [&]() {
+    rectangle_fitter.dropMoments();
+    rectangle_fitter.fitRectangle(r, v);
+  });
+
+  vector<Moments> moments(2);
+  vector<Line> fitted_lines;
+  vector<double> variances;
+  auto findMoments = [&]() {
+    line_fitter.dropMoments();
+    rectangle_fitter.dropMoments();
+    moments[0] = line_fitter.findMoments();
+    moments[1] = rectangle_fitter.findMoments();
+  };
+
+  measure("FigureFitter::fitParallelLines+variance", data, 2 * n, [&]() {
+    findMoments();
+    FigureFitter::fitParallelLines(moments, fitted_lines, variances);
+  });
+  measure("FigureFitter::fitManhattanLines+variance", data, 2 * n, [&]() {
+    findMoments();
+    FigureFitter::fitManhattanLines(moments, fitted_lines, variances);
+  });
+}
+
+void benchmarkQueries(const string& name, const Figure& figure, size_t n,
+                      const string& data, const vector<Point>& queries) {
+  measure(name + "::distanceTo", data, n, [&]() {
+    double sum = 0.0;
+    for (const Point& q : queries)
+      sum += figure.distanceTo(q);
+    sink = sum;
+  });
+
+  measure(name + "::distanceSquaredTo", data, n, [&]() {
+    double sum = 0.0;
+    for (const Point& q : queries)
+      sum += figure.distanceSquaredTo(q);
+    sink = sum;
+  });
+
+  measure(name + "::findProjectionOf", data, n, [&]() {
+    double sum = 0.0;
+    for (const Point& q : queries)
+      sum += figure.findProjectionOf(q).x;
+    sink = sum;
+  });
+
+  measure(name + "::normalTo", data, n, [&]() {
+    double sum = 0.0;
+    for (const Point& q : queries)
+      sum += figure.normalTo(q).x;
+    sink = sum;
+  });
+}
+
+void benchmarkFigures(size_t n, const string& data, double noise) {
+  // Clean queries lie on the figures, noisy ones are scattered around them,
+  // which exercises different branches of the projections
+  const Point origin(0.0, 0.0);
+  vector<pair<string, const Figure*>> figures = {
+    {"Point", &origin}, {"Line", &line}, {"Segment", &segment},
+    {"Circle", &circle}, {"Arc", &arc}, {"Ellipse", &ellipse},
+    {"Rectangle", &rectangle}};
+
+  WorkloadGenerator generator(6);
+
+  for (const auto& figure : figures) {
+    vector<Point> queries(n);
+    for (Point& q : queries) {
+      q = Point(generator.uniform(-5.0, 5.0), generator.uniform(-5.0, 5.0));
+      if (noise == 0.0 && figure.second != &origin)
+        q = figure.second->findProjectionOf(q);
+    }
+
+    // Points on the figure have no normal, move them off slightly
+    for (Point& q : queries)
+      if (figure.second->distanceSquaredTo(q) == 0.0)
+        q.x += 1e-6;
+
+    benchmarkQueries(figure.first, *figure.second, n, data, queries);
+  }
+}
+
+void benchmarkKernels(size_t n, const string& data, double noise) {
+  WorkloadGenerator generator(n);
+  PointCloud2D points, output(n);
+  generator.sample(arc, n, noise, points);
+  const double* x = points.xData();
+  const double* y = points.yData();
+
+  for (kernels::Isa isa : {kernels::Isa::Baseline, kernels::Isa::AVX2,
+                           kernels::Isa::AVX512}) {
+    const kernels::KernelTable* k = kernels::find(isa);
+    if (!k)
+      continue;
+
+    const string suffix = string("[") + kernels::toString(isa) + "]";
+    double sums[9];
+    double bounds[2];
+
+    measure("kernels::moments" + suffix, data, n, [&]() {
+      k->moments(x, y, n, sums);
+      sink = sums[2];
+    });
+    measure("kernels::cubicMoments" + suffix, data, n, [&]() {
+      k->cubicMoments(x, y, n, sums);
+      sink = sums[5];
+    });
+    measure("kernels::circleDistanceSquared" + suffix, data, n, [&]() {
+      sink = k->circleDistanceSquared(x, y, n, 1.0, -2.0, 3.0);
+    });
+    measure("kernels::countInAnnulus" + suffix, data, n, [&]() {
+      sink = double(k->countInAnnulus(x, y, n, 1.0, -2.0, 4.0, 16.0));
+    });
+    measure("kernels::circleCenterStep" + suffix, data, n, [&]() {
+      sink = double(k->circleCenterStep(x, y, n, 1.0, -2.0, 3.0, 1.0, sums));
+    });
+    measure("kernels::projectOntoLine" + suffix, data, n, [&]() {
+      sink = k->projectOntoLine(x, y, n, 0.6, 0.8, -1.0, -0.8, 0.6, nullptr,
+                                bounds);
+    });
+    measure("kernels::transform" + suffix, data, n, [&]() {
+      k->transform(x, y, n, 0.6, 0.8, 1.0, 2.0, output.xData(),
+                   output.yData());
+      sink = output.x(0);
+    });
+  }
+}
+
+void benchmarkVec(size_t n, const string& data) {
+  WorkloadGenerator generator(7);
+
+  vector<Vec> a(n), b(n);
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = Vec(generator.uniform(-5.0, 5.0), generator.uniform(-5.0, 5.0));
+    b[i] = Vec(generator.uniform(-5.0, 5.0), generator.uniform(-5.0, 5.0));
+  }
+
+  measure("Vec::operator+", data, n, [&]() {
+    Vec sum;
+    for (size_t i = 0; i < n; ++i)
+      sum += a[i] + b[i];
+    sink = sum.x;
+  });
+  measure("Vec::dot", data, n, [&]() {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      sum += a[i].dot(b[i]);
+    sink = sum;
+  });
+  measure("Vec::cross", data, n, [&]() {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      sum += a[i].cross(b[i]);
+    sink = sum;
+  });
+  measure("Vec::length", data, n, [&]() {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      sum += a[i].length();
+    sink = sum;
+  });
+  measure("Vec::normalized", data, n, [&]() {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      sum += a[i].normalized().x;
+    sink = sum;
+  });
+  measure("Vec::rotated", data, n, [&]() {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      sum += a[i].rotated(0.1).x;
+    sink = sum;
+  });
+  measure("Vec::angle", data, n, [&]() {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      sum += a[i].angle();
+    sink = sum;
+  });
+}
+
+//
+// Allocation check
+//
+
+/*
+ * Fits every figure with a fitter constructed upon a FitWorkspace, first to
+ * warm up the workspace and then counting allocations, and does the same for
+ * a fitter reused with assign() and append(), for the constrained fits of
+ * reused fitters, for per-frame containers taken from a FrameArena and for
+ * frames passed through a ScanPipeline fitting on a ThreadPool. Returns the
+ * number of fits which allocated.
+ */
+size_t checkAllocations(size_t n) {
+  WorkloadGenerator generator(n);
+  PointCloud2D lines, collinear, circles, ellipses, rectangles;
+  generator.sample(segment, n, 0.01, lines);
+  generator.sample(segment, n, 0.0, collinear);
+  generator.sample(arc, n, 0.01, circles);
+  generator.sample(ellipse, n, 0.01, ellipses);
+  generator.sample(rectangle, n, 0.01, rectangles);
+
+  Point p;
+  Line l;
+  Segment s;
+  Circle c;
+  Ellipse e;
+  Rectangle r;
+  double v;
+  FigureFitter reused;
+  FrameArena arena(1024);
+  ScanClusterer clusterer(0.05);
+  PolylineSimplifier simplifier;
+  vector<size_t> vertices;
+
+  // Walls of a room for the constrained fits, one fitter per wall
+  vector<FigureFitter> walls(4);
+  vector<Moments> wall_moments(walls.size());
+  FrameArena wall_arena(1024);
+  figfit::pmr::LineArray arena_lines(&wall_arena);
+  std::pmr::vector<double> arena_variances(&wall_arena);
+  vector<Line> wall_lines;
+  vector<double> wall_variances;
+  auto assignWalls = [&]() {
+    for (size_t i = 0; i < walls.size(); ++i) {
+      walls[i].assign(rectangles.view(i * n / 4, (i + 1) * n / 4));
+      wall_moments[i] = walls[i].findMoments();
+    }
+  };
+
+  // Scan of a corridor passed through the pipeline, a single frame is warmed
+  // up by the first call
+  ThreadPool pool(2);
+  ScanPipeline pipeline(clusterer, 1, n, &pool);
+  LaserScan scan(-M_PI / 2.0, M_PI / n, 0.1, 30.0);
+  scan.ranges.resize(n);
+  generator.simulateScan(generator.createCorridor(), Point(1.0, 1.5), 0.0,
+                         NoiseModel(0.01), scan);
+  pipeline.start();
+
+  const vector<pair<string, function<void(FitWorkspace&)>>> fits = {
+    {"fitPoint", [&](FitWorkspace& w) {
+      FigureFitter(lines, w).fitPoint(p, v); }},
+    {"fitLine", [&](FitWorkspace& w) {
+      FigureFitter(lines, w).fitLine(l, v); }},
+    {"fitSegment", [&](FitWorkspace& w) {
+      FigureFitter(lines, w).fitSegment(s, v); }},
+    {"fitSegment(MinMax)", [&](FitWorkspace& w) {
+      FigureFitter(lines, w).fitSegment(s, v, SegmentExtent::MinMax); }},
+    {"fitSegment(Trimmed)", [&](FitWorkspace& w) {
+      FigureFitter(lines, w).fitSegment(s, v, SegmentExtent::Trimmed); }},
+    {"fitCircle", [&](FitWorkspace& w) {
+      FigureFitter(circles, w).fitCircle(c, v); }},
+    {"fitCircleOfRadius", [&](FitWorkspace& w) {
+      FigureFitter(circles, w).fitCircleOfRadius(c, circle.radius(), v); }},
+    {"fitEllipse", [&](FitWorkspace& w) {
+      FigureFitter(ellipses, w).fitEllipse(e, v); }},
+    {"fitRectangle", [&](FitWorkspace& w) {
+      FigureFitter(rectangles, w).fitRectangle(r, v); }},
+    {"assign", [&](FitWorkspace&) {
+      reused.assign(lines);
+      reused.fitSegment(s, v);
+      reused.append(circles);
+      reused.fitCircle(c, v); }},
+    {"tryFit(failure)", [&](FitWorkspace& w) {
+      FigureFitter fitter(collinear, w);
+      fitter.tryFitCircle(c, v);
+      fitter.tryFitEllipse(e, v);
+      fitter.tryFitSegment(s, v, SegmentExtent::Trimmed, 0.5);
+      FigureFitter(lines.view(0, 1), w).tryFitLine(l, v); }},
+    {"FrameArena", [&](FitWorkspace& w) {
+      arena.rewind();
+      PointCloud2D cloud(rectangles.view(), &arena);
+      figfit::pmr::ClusterArray clusters(&arena);
+      figfit::pmr::SegmentArray segments(&arena);
+      clusterer.cluster(cloud, clusters);
+      for (const Cluster& cluster : clusters) {
+        segments.emplace_back();
+        FigureFitter(cluster.view(cloud), w).fitSegment(segments.back());
+      }
+      figfit::pmr::SegmentArray moved(&arena);
+      Transform2D(1.0, 2.0, 0.5).apply(segments, moved);
+      Transform2D(1.0, 2.0, 0.5).apply(moved);
+      simplifier.simplifyDouglasPeucker(cloud, 0.05, vertices);
+      PolylineSimplifier::toSegments(cloud, vertices, segments); }},
+    {"fitParallelLines", [&](FitWorkspace&) {
+      assignWalls();
+      FigureFitter::fitParallelLines(wall_moments, wall_lines,
+                                     wall_variances);
+      FigureFitter::fitParallelLines(wall_moments, wall_lines); }},
+    {"fitPerpendicularLines", [&](FitWorkspace&) {
+      Line l2;
+      double v2;
+      assignWalls();
+      FigureFitter::fitPerpendicularLines(walls[0], walls[1], l, l2, v, v2); }},
+    {"fitManhattanLines", [&](FitWorkspace&) {
+      assignWalls();
+      FigureFitter::fitManhattanLines(wall_moments, wall_lines,
+                                      wall_variances);
+      FigureFitter::fitManhattanLines(wall_moments, wall_lines); }},
+    {"fitManhattanLines(pmr)", [&](FitWorkspace&) {
+      assignWalls();
+      FigureFitter::fitManhattanLines(wall_moments, arena_lines,
+                                      arena_variances);
+      FigureFitter::fitParallelLines(wall_moments, arena_lines); }},
+    {"ScanPipeline", [&](FitWorkspace&) {
+      ScanFrame* frame = pipeline.acquire();
+      frame->scan.angle_min = scan.angle_min;
+      frame->scan.angle_increment = scan.angle_increment;
+      frame->scan.range_min = scan.range_min;
+      frame->scan.range_max = scan.range_max;
+      frame->scan.ranges.assign(scan.ranges.begin(), scan.ranges.end());
+      pipeline.submit(frame);
+      while (!(frame = pipeline.receive()))
+        this_thread::yield();
+      pipeline.release(frame); }}
+  };
+
+  size_t failures = 0;
+  for (const auto& fit : fits) {
+    FitWorkspace workspace;
+    fit.second(workspace);
+
+    AllocationCounter counter;
+    for (int i = 0; i < 10; ++i)
+      fit.second(workspace);
+    size_t allocated = counter.allocations();
+
+    cerr << fit.first << " [N = " << n << "]: "
+         << allocated << " allocations\n";
+    failures += (allocated > 0);
+  }
+
+  return failures;
+}
+
+//
+// Output
+//
+
+string escape(const string& s) {
+  string escaped;
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+void writeJson(ostream& out) {
+  out << "{\n  \"context\": {\"compiler\": \"" << escape(__VERSION__)
+      << "\", \"min_time\": " << options.min_time << "},\n"
+      << "  \"benchmarks\": [\n";
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Measurement& r = results[i];
+    out << "    {\"name\": \"" << escape(r.name) << "\", \"data\": \""
+        << r.data << "\", \"n\": " << r.n << ", \"iterations\": "
+        << r.iterations << ", \"ns_per_call\": " << r.ns_per_call
+        << ", \"ns_per_point\": " << r.ns_per_call / r.n
+        << ", \"allocations_per_call\": " << r.allocations_per_call << "}"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+
+  out << "  ]\n}\n";
+}
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options]\n"
+       << "  --output FILE      write JSON to file (default: stdout)\n"
+       << "  --filter TEXT      run benchmarks whose name contains text\n"
+       << "  --min-time S       minimal time per benchmark (default: 0.1)\n"
+       << "  --max-n N          largest number of points (default: 1000000)\n"
+       << "  --check-allocations  check that fits with workspace do not "
+          "allocate\n";
+}
+
+int main(int argc, char** argv) {
+  bool check_allocations = false;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    bool has_value = (i + 1 < argc);
+
+    if (arg == "--output" && has_value)
+      options.output = argv[++i];
+    else if (arg == "--filter" && has_value)
+      options.filter = argv[++i];
+    else if (arg == "--min-time" && has_value)
+      options.min_time = strtod(argv[++i], nullptr);
+    else if (arg == "--max-n" && has_value)
+      options.max_n = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--check-allocations")
+      check_allocations = true;
+    else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (check_allocations) {
+    size_t failures = checkAllocations(10) + checkAllocations(1000);
+    if (failures > 0)
+      cerr << failures << " fits allocated memory\n";
+    return failures > 0 ? 1 : 0;
+  }
+
+  const vector<size_t> sizes = {3, 10, 30, 100, 300, 1000, 3000, 10000, 30000,
+                                100000, 300000, 1000000};
+  const vector<pair<string, double>> datasets = {{"clean", 0.0},
+                                                 {"noisy", 0.05}};
+
+  for (size_t n : sizes) {
+    if (n > options.max_n)
+      break;
+
+    for (const auto& data : datasets) {
+      benchmarkFits(n, data.first, data.second);
+      benchmarkFigures(n, data.first, data.second);
+      benchmarkKernels(n, data.first, data.second);
+    }
+    benchmarkVec(n, "random");
+  }
+
+  if (options.output.empty()) {
+    writeJson(cout);
+  }
+  else {
+    ofstream file(options.output);
+    writeJson(file);
+  }
+
+  return 0;
+}
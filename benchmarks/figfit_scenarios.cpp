@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../clustering.h"
+#include "../figure_fitter.h"
+#include "../figure_log.h"
+#include "../laser_scan.h"
+#include "../thread_pool.h"
+#include "../workload_generator.h"
+
+using namespace std;
+using namespace figfit;
+
+/*
+ * End-to-end benchmark of the scan processing chain: ingestion (conversion of
+ * a scan into points), clustering, fitting of segments and finding of their
+ * variances. Frames come from ray-cast synthetic environments or from a
+ * recorded log. Every frame is processed by a single worker, the frames are
+ * spread over 1 to N workers. Latency percentiles are reported per frame and
+ * per stage, together with the throughput for every number of workers.
+ */
+
+//
+// Synthetic environments
+//
+
+/*
+ * Scans of a 270 degree lidar moving along a trajectory
+ */
+vector<LaserScan> simulate(const Scene& scene, size_t frames, size_t beams,
+                           const NoiseModel& noise, const string& path,
+                           WorkloadGenerator& generator) {
+  const double fov = 1.5 * M_PI, max_range = 30.0;
+
+  vector<LaserScan> scans(frames);
+  for (size_t f = 0; f < frames; ++f) {
+    double t = double(f) / frames;
+    Point position;
+    double heading;
+
+    if (path == "corridor") {
+      position = Point(2.0 + 90.0 * t, 1.5);
+      heading = 0.0;
+    }
+    else {
+      position = Point(8.0 * cos(2.0 * M_PI * t), 8.0 * sin(2.0 * M_PI * t));
+      heading = 2.0 * M_PI * t + M_PI / 2.0;
+    }
+
+    LaserScan& scan = scans[f];
+    scan = LaserScan(-fov / 2.0, fov / (beams - 1), 0.05, max_range);
+    scan.ranges.resize(beams);
+    generator.simulateScan(scene, position, heading, noise, scan);
+  }
+
+  return scans;
+}
+
+//
+// Processing chain
+//
+
+enum Stage { Ingestion, Clustering, Fitting, Variance, Stages };
+const char* stage_names[Stages] = {"ingestion", "clustering", "fitting",
+                                   "variance"};
+
+struct Workspace
+{
+  ScanConverter converter;
+  PointCloud2D cloud;
+  vector<size_t> beams;
+  ClusterArray clusters;
+  FitWorkspace fit;
+  SegmentArray segments;
+  vector<double> variances;
+};
+
+struct Timing
+{
+  double frame;
+  double stages[Stages];
+};
+
+struct Scenario
+{
+  string name;
+  vector<LaserScan> scans;        // Synthetic frames
+  vector<PointCloudView> views;   // Recorded frames
+  size_t points = 0;
+
+  size_t size() const {
+    return scans.empty() ? views.size() : scans.size();
+  }
+};
+
+void processFrame(const Scenario& scenario, size_t frame,
+                  const ScanClusterer& clusterer, Workspace& ws,
+                  Timing& timing) {
+  typedef chrono::steady_clock Clock;
+  Clock::time_point t[Stages + 1];
+
+  t[Ingestion] = Clock::now();
+  if (!scenario.scans.empty()) {
+    ws.converter.convert(scenario.scans[frame], ws.cloud, ws.beams);
+  }
+  else {
+    const PointCloudView& view = scenario.views[frame];
+    ws.cloud.resize(view.size());
+    copy(view.xData(), view.xData() + view.size(), ws.cloud.xData());
+    copy(view.yData(), view.yData() + view.size(), ws.cloud.yData());
+  }
+
+  t[Clustering] = Clock::now();
+  clusterer.cluster(ws.cloud, ws.clusters);
+
+  t[Fitting] = Clock::now();
+  ws.segments.resize(ws.clusters.size());
+  for (size_t i = 0; i < ws.clusters.size(); ++i) {
+    FigureFitter fitter(ws.clusters[i].view(ws.cloud), ws.fit);
+    if (fitter.tryFitSegment(ws.segments[i], SegmentExtent::MinMax) !=
+        FitStatus::Ok)
+      ws.segments[i] = Segment();
+  }
+
+  t[Variance] = Clock::now();
+  ws.variances.resize(ws.clusters.size());
+  for (size_t i = 0; i < ws.clusters.size(); ++i) {
+    PointCloudView points = ws.clusters[i].view(ws.cloud);
+    double sum = 0.0;
+    for (size_t j = 0; j < points.size(); ++j)
+      sum += ws.segments[i].distanceSquaredTo(points.point(j));
+    ws.variances[i] = sum / points.size();
+  }
+
+  t[Stages] = Clock::now();
+
+  for (int s = 0; s < Stages; ++s)
+    timing.stages[s] = chrono::duration<double, micro>(t[s + 1] -
+                                                       t[s]).count();
+  timing.frame = chrono::duration<double, micro>(t[Stages] -
+                                                 t[Ingestion]).count();
+}
+
+//
+// Statistics and output
+//
+
+struct Percentiles
+{
+  double p50, p99, p999, max;
+};
+
+Percentiles findPercentiles(vector<double> values) {
+  sort(values.begin(), values.end());
+  auto rank = [&values](double q) {
+    size_t i = size_t(ceil(q * values.size()));
+    return values[min(max<size_t>(i, 1), values.size()) - 1];
+  };
+
+  return Percentiles{rank(0.5), rank(0.99), rank(0.999), values.back()};
+}
+
+void writePercentiles(ostream& out, const vector<double>& values) {
+  Percentiles p = findPercentiles(values);
+  out << "{\"p50_us\": " << p.p50 << ", \"p99_us\": " << p.p99
+      << ", \"p999_us\": " << p.p999 << ", \"max_us\": " << p.max << "}";
+}
+
+/*
+ * Runs all frames of a scenario with given number of workers
+ */
+void runScenario(const Scenario& scenario, size_t threads, size_t repeats,
+                 const ScanClusterer& clusterer, ostream& out) {
+  ThreadPool pool(threads);
+  PerWorker<Workspace> workspaces(pool);
+  const size_t frames = scenario.size();
+  vector<Timing> timings(frames * repeats);
+
+  // Warm-up grows the workspaces to their final sizes
+  pool.parallelFor(min(frames, 4 * threads), [&](size_t i, size_t worker) {
+    Timing timing;
+    processFrame(scenario, i, clusterer, workspaces[worker], timing);
+  });
+
+  auto start = chrono::steady_clock::now();
+  pool.parallelFor(frames * repeats, [&](size_t i, size_t worker) {
+    processFrame(scenario, i % frames, clusterer, workspaces[worker],
+                 timings[i]);
+  });
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                            start).count();
+
+  vector<double> values(timings.size());
+  for (size_t i = 0; i < timings.size(); ++i)
+    values[i] = timings[i].frame;
+
+  out << "    {\"scenario\": \"" << scenario.name << "\", \"threads\": "
+      << threads << ", \"frames\": " << timings.size()
+      << ", \"points_per_frame\": " << double(scenario.points) / frames
+      << ", \"frames_per_s\": " << timings.size() / seconds
+      << ",\n     \"frame\": ";
+  writePercentiles(out, values);
+
+  for (int s = 0; s < Stages; ++s) {
+    for (size_t i = 0; i < timings.size(); ++i)
+      values[i] = timings[i].stages[s];
+    out << ",\n     \"" << stage_names[s] << "\": ";
+    writePercentiles(out, values);
+  }
+  out << "}";
+
+  cerr << scenario.name << ", " << threads << " threads: "
+       << timings.size() / seconds << " frames/s\n";
+}
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options]\n"
+       << "  --output FILE      write JSON to file (default: stdout)\n"
+       << "  --log FILE         add scenario of a recorded log\n"
+       << "  --frames N         frames per synthetic scenario (default: "
+          "500)\n"
+       << "  --beams N          beams per scan (default: 1081)\n"
+       << "  --noise S          range noise (default: 0.01)\n"
+       << "  --repeats N        passes over the frames (default: 4)\n"
+       << "  --threads N        largest number of workers (default: all "
+          "cores)\n"
+       << "  --seed N           seed of the environments (default: 1)\n";
+}
+
+int main(int argc, char** argv) {
+  string output, log;
+  size_t frames = 500, beams = 1081, repeats = 4;
+  size_t max_threads = max(1u, thread::hardware_concurrency());
+  double noise = 0.01;
+  unsigned seed = 1;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    bool has_value = (i + 1 < argc);
+
+    if (arg == "--output" && has_value)
+      output = argv[++i];
+    else if (arg == "--log" && has_value)
+      log = argv[++i];
+    else if (arg == "--frames" && has_value)
+      frames = max<size_t>(1, strtoul(argv[++i], nullptr, 10));
+    else if (arg == "--beams" && has_value)
+      beams = max<size_t>(2, strtoul(argv[++i], nullptr, 10));
+    else if (arg == "--noise" && has_value)
+      noise = strtod(argv[++i], nullptr);
+    else if (arg == "--repeats" && has_value)
+      repeats = max<size_t>(1, strtoul(argv[++i], nullptr, 10));
+    else if (arg == "--threads" && has_value)
+      max_threads = max<size_t>(1, strtoul(argv[++i], nullptr, 10));
+    else if (arg == "--seed" && has_value)
+      seed = strtoul(argv[++i], nullptr, 10);
+    else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  try {
+    WorkloadGenerator generator(seed);
+    NoiseModel noise_model(noise);
+    noise_model.dropout_rate = 0.01;
+
+    vector<Scenario> scenarios(3);
+    scenarios[0].name = "corridor";
+    scenarios[0].scans = simulate(generator.createCorridor(), frames, beams,
+                                  noise_model, "corridor", generator);
+    scenarios[1].name = "pillars";
+    scenarios[1].scans = simulate(generator.createPillars(), frames, beams,
+                                  noise_model, "loop", generator);
+    scenarios[2].name = "clutter";
+    scenarios[2].scans = simulate(generator.createClutter(), frames, beams,
+                                  noise_model, "loop", generator);
+
+    for (Scenario& scenario : scenarios) {
+      ScanConverter converter;
+      PointCloud2D cloud;
+      for (const LaserScan& scan : scenario.scans) {
+        converter.convert(scan, cloud);
+        scenario.points += cloud.size();
+      }
+    }
+
+    unique_ptr<LogReader> reader;
+    if (!log.empty()) {
+      reader.reset(new LogReader(log));
+      Scenario recorded;
+      recorded.name = "log";
+      for (size_t i = 0; i < reader->size(); ++i) {
+        recorded.views.push_back(reader->frame(i).points);
+        recorded.points += recorded.views.back().size();
+      }
+      if (!recorded.views.empty())
+        scenarios.push_back(recorded);
+    }
+
+    vector<size_t> thread_counts;
+    for (size_t t = 1; t < max_threads; t *= 2)
+      thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    ofstream file;
+    if (!output.empty())
+      file.open(output);
+    ostream& out = output.empty() ? cout : file;
+
+    ScanClusterer clusterer(0.1, 0.02, 3);
+    out << "{\n  \"results\": [\n";
+    bool first = true;
+    for (const Scenario& scenario : scenarios)
+      for (size_t threads : thread_counts) {
+        out << (first ? "" : ",\n");
+        runScenario(scenario, threads, repeats, clusterer, out);
+        first = false;
+      }
+    out << "\n  ]\n}\n";
+  }
+  catch (const exception& e) {
+    cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cmath>
+#include <memory_resource>
+#include <vector>
+
+#include "../point_cloud.h"
+
+namespace figfit
+{
+
+/**
+ * @struct Cluster clustering.h
+ *
+ * @brief Range of consecutive points of an ordered point cloud
+ */
+struct Cluster
+{
+  size_t first;   /**< @brief Index of the first point of the cluster */
+  size_t last;    /**< @brief Index past the last point of the cluster */
+
+  /**
+   * @brief Get number of points of the cluster
+   */
+  size_t size() const {
+    return last - first;
+  }
+
+  /**
+   * @brief Get view of points of the cluster
+   *
+   * @param points is the view of the clustered point cloud
+   */
+  PointCloudView view(const PointCloudView& points) const {
+    return points.subview(first, last);
+  }
+};
+
+/**
+ * @brief Array of clusters
+ */
+typedef std::vector<Cluster> ClusterArray;
+
+namespace pmr
+{
+
+/**
+ * @brief Array of clusters taking memory from a std::pmr::memory_resource
+ */
+typedef std::pmr::vector<Cluster> ClusterArray;
+
+} // end namespace pmr
+
+/**
+ * @class ScanClusterer clustering.h
+ *
+ * @brief Break-point clustering of ordered scans
+ *
+ * Splits a point cloud ordered by the beam angle wherever the distance between
+ * consecutive points exceeds a threshold. The threshold grows linearly with
+ * the range of the points, which compensates for the growing spacing of beams
+ * far from the sensor. Clusters with too few points are dropped.
+ */
+class ScanClusterer
+{
+public:
+
+  /**
+   * @brief Construction from thresholds (default)
+   *
+   * @param distance is the constant part of the threshold
+   * @param ratio is the part of the threshold proportional to range
+   * @param min_points is the minimal number of points of a cluster
+   */
+  ScanClusterer(double distance = 0.1, double ratio = 0.0,
+                size_t min_points = 3) :
+    distance_(distance),
+    ratio_(ratio),
+    min_points_(min_points)
+  {}
+
+  /**
+   * @brief Divide point cloud into clusters
+   *
+   * The storage of the clusters array is reused if its capacity suffices.
+   * Any vector of clusters is accepted, e.g. ClusterArray or
+   * pmr::ClusterArray.
+   *
+   * @param points is the view of points ordered by the beam angle
+   * @param clusters is a placeholder for the resulting clusters
+   */
+  template <typename Allocator>
+  void cluster(const PointCloudView& points,
+               std::vector<Cluster, Allocator>& clusters) const {
+    clusters.clear();
+    const size_t n = points.size();
+    if (n == 0)
+      return;
+
+    const double* x = points.xData();
+    const double* y = points.yData();
+
+    size_t first = 0;
+    for (size_t i = 1; i <= n; ++i) {
+      bool split = (i == n);
+
+      if (!split) {
+        double dx = x[i] - x[i - 1];
+        double dy = y[i] - y[i - 1];
+        double threshold = distance_;
+        if (ratio_ != 0.0)
+          threshold += ratio_ * sqrt(x[i - 1] * x[i - 1] + y[i - 1] * y[i - 1]);
+
+        split = (dx * dx + dy * dy > threshold * threshold);
+      }
+
+      if (split) {
+        if (i - first >= min_points_)
+          clusters.push_back(Cluster{first, i});
+        first = i;
+      }
+    }
+  }
+
+private:
+
+  double distance_;     /**< @brief Constant part of the threshold */
+  double ratio_;        /**< @brief Part of the threshold per unit range */
+  size_t min_points_;   /**< @brief Minimal number of points of a cluster */
+};
+
+} // end namespace figfit
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "../point_cloud.h"
+
+namespace figfit
+{
+
+/**
+ * @class ConvexHull convex_hull.h
+ *
+ * @brief Convex hull of a point set
+ *
+ * Computes the convex hull as indices of points into the given view, in
+ * counter-clockwise order and without collinear points on the edges. The
+ * object keeps its buffers between calls, so a single instance can be reused
+ * for many point sets without reallocating. The hull is a cheap bound of a
+ * cluster, e.g. for pruning queries or before the more expensive fits of
+ * FigureFitter.
+ */
+class ConvexHull
+{
+public:
+
+  /**
+   * @brief Compute convex hull of arbitrary point set
+   *
+   * Uses the monotone chain algorithm of A. M. Andrew, which sorts the points
+   * lexicographically and builds the lower and upper hulls in O(N log N).
+   *
+   * @param points is the view of points
+   */
+  void compute(const PointCloudView& points) {
+    const size_t n = points.size();
+    hull_.clear();
+
+    if (n < 3) {
+      for (size_t i = 0; i < n; ++i)
+        if (i == 0 || points.point(i) != points.point(0))
+          hull_.push_back(i);
+      return;
+    }
+
+    const double* x = points.xData();
+    const double* y = points.yData();
+
+    order_.resize(n);
+    for (size_t i = 0; i < n; ++i)
+      order_[i] = i;
+
+    std::sort(order_.begin(), order_.end(), [x, y](size_t a, size_t b) {
+      return x[a] < x[b] || (x[a] == x[b] && y[a] < y[b]);
+    });
+
+    hull_.resize(2 * n);
+    size_t k = 0;
+
+    // Lower hull
+    for (size_t i = 0; i < n; ++i) {
+      while (k >= 2 &&
+             turn(points, hull_[k - 2], hull_[k - 1], order_[i]) <= 0.0)
+        k--;
+      hull_[k++] = order_[i];
+    }
+
+    // Upper hull
+    for (size_t i = n - 1, lower = k + 1; i > 0; --i) {
+      while (k >= lower &&
+             turn(points, hull_[k - 2], hull_[k - 1], order_[i - 1]) <= 0.0)
+        k--;
+      hull_[k++] = order_[i - 1];
+    }
+
+    // The last point repeats the first one
+    hull_.resize(k > 1 ? k - 1 : k);
+  }
+
+  /**
+   * @brief Compute convex hull of a scan ordered by angle
+   *
+   * Uses the algorithm of A. Melkman, which computes the hull of a simple
+   * polygonal chain in O(N). Points of a range scan sorted by the beam angle
+   * within one revolution form such a chain, because every ray from the sensor
+   * crosses it at most once. If the first three points are collinear, the
+   * method falls back to compute().
+   *
+   * @param points is the view of points ordered along a simple chain
+   */
+  void computeFromScan(const PointCloudView& points) {
+    const size_t n = points.size();
+
+    if (n < 3 || turn(points, 0, 1, 2) == 0.0) {
+      compute(points);
+      return;
+    }
+
+    // Deque of indices stored in array with room to grow in both directions
+    deque_.resize(2 * n + 1);
+    size_t bottom = n - 2;
+    size_t top = bottom + 3;
+
+    deque_[bottom] = deque_[top] = 2;
+    if (turn(points, 0, 1, 2) > 0.0) {
+      deque_[bottom + 1] = 0;
+      deque_[bottom + 2] = 1;
+    }
+    else {
+      deque_[bottom + 1] = 1;
+      deque_[bottom + 2] = 0;
+    }
+
+    for (size_t i = 3; i < n; ++i) {
+      if (turn(points, deque_[bottom], deque_[bottom + 1], i) > 0.0 &&
+          turn(points, deque_[top - 1], deque_[top], i) > 0.0)
+        continue;
+
+      while (turn(points, deque_[bottom], deque_[bottom + 1], i) <= 0.0)
+        bottom++;
+      deque_[--bottom] = i;
+
+      while (turn(points, deque_[top - 1], deque_[top], i) <= 0.0)
+        top--;
+      deque_[++top] = i;
+    }
+
+    hull_.assign(deque_.begin() + bottom, deque_.begin() + top);
+  }
+
+  /**
+   * @brief Get indices of hull vertices in counter-clockwise order
+   */
+  const std::vector<size_t>& indices() const {
+    return hull_;
+  }
+
+  /**
+   * @brief Get number of hull vertices
+   */
+  size_t size() const {
+    return hull_.size();
+  }
+
+  /**
+   * @brief Check if a given point is inside the hull
+   *
+   * Point lying on the boundary of the hull is assumed to be inside it.
+   *
+   * @param points is the view of points the hull was computed for
+   * @param p is a given point
+   *
+   * @return true if p is inside the hull
+   */
+  bool isEnclosing(const PointCloudView& points, const Point& p) const {
+    if (hull_.size() < 3)
+      return false;
+
+    for (size_t i = 0; i < hull_.size(); ++i) {
+      Point a = points.point(hull_[i]);
+      Point b = points.point(hull_[(i + 1) % hull_.size()]);
+      if ((b - a).cross(p - a) < 0.0)
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+
+  /**
+   * @brief Get orientation of three points
+   *
+   * @return positive value for counter-clockwise turn, negative value for
+   * clockwise turn and zero for collinear points
+   */
+  static double turn(const PointCloudView& points,
+                     size_t a, size_t b, size_t c) {
+    double x_a = points.x(a), y_a = points.y(a);
+    return (points.x(b) - x_a) * (points.y(c) - y_a) -
+           (points.y(b) - y_a) * (points.x(c) - x_a);
+  }
+
+  std::vector<size_t> order_;   /**< @brief Buffer of sorted indices */
+  std::vector<size_t> deque_;   /**< @brief Buffer of Melkman deque */
+  std::vector<size_t> hull_;    /**< @brief Indices of hull vertices */
+};
+
+} // end namespace figfit
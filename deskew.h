@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "../point_cloud.h"
+#include "../transform.h"
+
+namespace figfit
+{
+
+/**
+ * @class MotionDeskewer deskew.h
+ *
+ * @brief Correction of scan distortion caused by motion of the sensor
+ *
+ * Points of one sweep are measured at different times, while the sensor
+ * moves. The deskewer assumes constant linear and angular velocity between
+ * two poses of the sensor (e.g. from odometry) and moves each point into the
+ * sensor frame at a single reference time. Run it before clustering and
+ * fitting, so that straight walls stay straight.
+ *
+ * For a point measured at time t the correction is p' = R(w * tau) * p +
+ * u * tau, where tau = t - t_ref, w is the angular velocity and u is the
+ * linear velocity expressed in the reference frame. The rotation is updated
+ * incrementally from point to point: the small increment of angle is
+ * rotated in with its Taylor series, so no trigonometric functions are
+ * evaluated per point.
+ */
+class MotionDeskewer
+{
+public:
+
+  /**
+   * @brief Construction from two poses of the sensor
+   *
+   * @param start_pose is the pose of the sensor at start_time
+   * @param start_time is the time of the first pose
+   * @param end_pose is the pose of the sensor at end_time
+   * @param end_time is the time of the second pose
+   *
+   * @throw std::logic_error if the times are equal
+   */
+  MotionDeskewer(const Transform2D& start_pose, double start_time,
+                 const Transform2D& end_pose, double end_time) :
+    start_pose_(start_pose),
+    start_time_(start_time),
+    end_time_(end_time)
+  {
+    double duration = end_time - start_time;
+    if (duration == 0.0)
+      throw std::logic_error("Cannot interpolate poses with equal times");
+
+    double delta = end_pose.theta() - start_pose.theta();
+    angular_velocity_ = atan2(sin(delta), cos(delta)) / duration;
+    linear_velocity_ = Vec(end_pose.x() - start_pose.x(),
+                           end_pose.y() - start_pose.y()) / duration;
+  }
+
+  /**
+   * @brief Get pose of the sensor at given time
+   *
+   * @param time is the time of interpolation (or extrapolation)
+   *
+   * @return interpolated pose
+   */
+  Transform2D poseAt(double time) const {
+    double tau = time - start_time_;
+    return Transform2D(start_pose_.x() + linear_velocity_.x * tau,
+                       start_pose_.y() + linear_velocity_.y * tau,
+                       start_pose_.theta() + angular_velocity_ * tau);
+  }
+
+  /**
+   * @brief Deskew points with given time stamps
+   *
+   * @param cloud is the point cloud in the sensor frame, corrected in place
+   * @param stamps are the times of measurement of points
+   * @param reference_time is the time of the resulting sensor frame
+   *
+   * @throw std::logic_error if the sizes of cloud and stamps differ
+   */
+  void deskew(PointCloud2D& cloud, const std::vector<double>& stamps,
+              double reference_time) const {
+    if (stamps.size() != cloud.size())
+      throw std::logic_error("Cannot deskew points: there must be one time "
+                             "stamp per point");
+
+    const double* t = stamps.data();
+    deskew(cloud, reference_time, [t](size_t i) { return t[i]; });
+  }
+
+  /**
+   * @brief Deskew points with given time stamps into the end frame
+   *
+   * @param cloud is the point cloud in the sensor frame, corrected in place
+   * @param stamps are the times of measurement of points
+   */
+  void deskew(PointCloud2D& cloud, const std::vector<double>& stamps) const {
+    deskew(cloud, stamps, end_time_);
+  }
+
+  /**
+   * @brief Deskew points of a scan with constant time between beams
+   *
+   * The time of a point is first_time + beam * time_increment, where the beam
+   * indices come e.g. from ScanConverter::convert().
+   *
+   * @param cloud is the point cloud in the sensor frame, corrected in place
+   * @param beams are the indices of beams of points
+   * @param first_time is the time of the first beam of the scan
+   * @param time_increment is the time between consecutive beams
+   * @param reference_time is the time of the resulting sensor frame
+   *
+   * @throw std::logic_error if the sizes of cloud and beams differ
+   */
+  void deskew(PointCloud2D& cloud, const std::vector<size_t>& beams,
+              double first_time, double time_increment,
+              double reference_time) const {
+    if (beams.size() != cloud.size())
+      throw std::logic_error("Cannot deskew points: there must be one beam "
+                             "index per point");
+
+    const size_t* b = beams.data();
+    deskew(cloud, reference_time, [b, first_time, time_increment](size_t i) {
+      return first_time + b[i] * time_increment;
+    });
+  }
+
+private:
+
+  /**
+   * @brief Deskew points with time stamps given by a function of index
+   */
+  template <typename StampFunction>
+  void deskew(PointCloud2D& cloud, double reference_time,
+              StampFunction stamp) const {
+    const size_t n = cloud.size();
+    if (n == 0)
+      return;
+
+    // Linear velocity in the sensor frame at the reference time
+    double theta_ref = start_pose_.theta() +
+                       angular_velocity_ * (reference_time - start_time_);
+    Vec u = linear_velocity_.rotated(-theta_ref);
+    double w = angular_velocity_;
+
+    double* x = cloud.xData();
+    double* y = cloud.yData();
+
+    double tau = stamp(0) - reference_time;
+    double c = cos(w * tau);
+    double s = sin(w * tau);
+
+    for (size_t i = 0; i < n; ++i) {
+      double tau_i = stamp(i) - reference_time;
+      double delta = w * (tau_i - tau);
+      tau = tau_i;
+
+      if (std::abs(delta) < 1e-2) {
+        double d2 = delta * delta;
+        double c_d = 1.0 - d2 / 2.0 * (1.0 - d2 / 12.0);
+        double s_d = delta * (1.0 - d2 / 6.0 * (1.0 - d2 / 20.0));
+        double c_new = c * c_d - s * s_d;
+        s = s * c_d + c * s_d;
+        c = c_new;
+
+        // First-order renormalization keeps the rotation from drifting
+        double k = (3.0 - (c * c + s * s)) / 2.0;
+        c *= k;
+        s *= k;
+      }
+      else {
+        c = cos(w * tau);
+        s = sin(w * tau);
+      }
+
+      double x_i = x[i];
+      double y_i = y[i];
+      x[i] = c * x_i - s * y_i + u.x * tau;
+      y[i] = s * x_i + c * y_i + u.y * tau;
+    }
+  }
+
+  Transform2D start_pose_;    /**< @brief Pose of the sensor at start time */
+  double start_time_;         /**< @brief Time of the start pose */
+  double end_time_;           /**< @brief Time of the end pose */
+  double angular_velocity_;   /**< @brief Angular velocity of the sensor */
+  Vec linear_velocity_;       /**< @brief Linear velocity in the world frame */
+};
+
+} // end namespace figfit
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../point_cloud.h"
+#include "../figures/circle.h"
+
+namespace figfit
+{
+
+/**
+ * @class EnclosingCircle enclosing_circle.h
+ *
+ * @brief Minimum enclosing circle of a point set
+ *
+ * Finds the smallest circle containing all of the points with the randomized
+ * incremental algorithm of E. Welzl in its iterative form, which runs in
+ * expected O(N) time. The points are visited in a shuffled order kept in a
+ * buffer of the object, so a single instance can be reused for many point sets
+ * without reallocating. The random generator is seeded with a constant, hence
+ * the results are repeatable.
+ *
+ * Since the minimum enclosing circle of a set equals that of its convex hull,
+ * the circle can be computed for the vertices of ConvexHull only.
+ */
+class EnclosingCircle
+{
+public:
+
+  /**
+   * @brief Find minimum enclosing circle of all of the points
+   *
+   * @param points is the view of points
+   *
+   * @return minimum enclosing circle (radius 0 at (0, 0) for empty set)
+   */
+  Circle find(const PointCloudView& points) {
+    order_.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+      order_[i] = i;
+
+    return findInOrder(points);
+  }
+
+  /**
+   * @brief Find minimum enclosing circle of selected points
+   *
+   * @param points is the view of points
+   * @param indices are the indices of selected points, e.g. vertices of the
+   * convex hull
+   *
+   * @return minimum enclosing circle (radius 0 at (0, 0) for empty set)
+   */
+  Circle find(const PointCloudView& points,
+              const std::vector<size_t>& indices) {
+    order_.assign(indices.begin(), indices.end());
+    return findInOrder(points);
+  }
+
+private:
+
+  /**
+   * @brief Find minimum enclosing circle of points given in the buffer
+   */
+  Circle findInOrder(const PointCloudView& points) {
+    const size_t n = order_.size();
+    if (n == 0)
+      return Circle(Point(), 0.0);
+
+    std::shuffle(order_.begin(), order_.end(), random_engine_);
+
+    Point center = points.point(order_[0]);
+    double radius_squared = 0.0;
+
+    for (size_t i = 1; i < n; ++i) {
+      Point p_i = points.point(order_[i]);
+      if (isInside(p_i, center, radius_squared))
+        continue;
+
+      center = p_i;
+      radius_squared = 0.0;
+
+      for (size_t j = 0; j < i; ++j) {
+        Point p_j = points.point(order_[j]);
+        if (isInside(p_j, center, radius_squared))
+          continue;
+
+        center = (p_i + p_j) / 2.0;
+        radius_squared = (p_i - center).lengthSquared();
+
+        for (size_t k = 0; k < j; ++k) {
+          Point p_k = points.point(order_[k]);
+          if (isInside(p_k, center, radius_squared))
+            continue;
+
+          circumscribe(p_i, p_j, p_k, center, radius_squared);
+        }
+      }
+    }
+
+    return Circle(center, sqrt(radius_squared));
+  }
+
+  /**
+   * @brief Check if a point is inside the circle, with relative tolerance
+   */
+  static bool isInside(const Point& p, const Point& center,
+                       double radius_squared) {
+    return (p - center).lengthSquared() <= radius_squared * (1.0 + 1e-12);
+  }
+
+  /**
+   * @brief Find circle through three points
+   *
+   * For (nearly) collinear points the circle spanned on the farthest pair of
+   * points is taken, which contains the third point.
+   */
+  static void circumscribe(const Point& a, const Point& b, const Point& c,
+                           Point& center, double& radius_squared) {
+    Vec ab = b - a;
+    Vec ac = c - a;
+    double d = 2.0 * ab.cross(ac);
+
+    if (std::abs(d) > 1e-12 * (ab.lengthSquared() + ac.lengthSquared())) {
+      double ab_squared = ab.lengthSquared();
+      double ac_squared = ac.lengthSquared();
+      Vec offset((ac.y * ab_squared - ab.y * ac_squared) / d,
+                 (ab.x * ac_squared - ac.x * ab_squared) / d);
+
+      center = a + offset;
+      radius_squared = offset.lengthSquared();
+      return;
+    }
+
+    const Point* pairs[3][2] = {{&a, &b}, {&a, &c}, {&b, &c}};
+    radius_squared = -1.0;
+    for (auto& pair : pairs) {
+      double diameter_squared = (*pair[0] - *pair[1]).lengthSquared();
+      if (diameter_squared / 4.0 > radius_squared) {
+        center = (*pair[0] + *pair[1]) / 2.0;
+        radius_squared = diameter_squared / 4.0;
+      }
+    }
+  }
+
+  std::vector<size_t> order_;         /**< @brief Buffer of shuffled indices */
+  std::minstd_rand random_engine_;    /**< @brief Generator for shuffling */
+};
+
+} // end namespace figfit
@@ -17,7 +17,7 @@ const double std_dev = 0.2;
 default_random_engine random_engine;
 normal_distribution<double> distribution(mean, std_dev);
 
-auto roll = [&](){ return distribution(random_engine); };
+auto roll = [](){ return distribution(random_engine); };
 
 int main() {
   Point true_center(-3.0, 2.5);
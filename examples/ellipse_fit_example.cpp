@@ -0,0 +1,117 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+#include "../figures/ellipse.h"
+#include "../figure_fitter.h"
+#include "matplotlibcpp.h"
+
+using namespace std;
+using namespace figfit;
+namespace plt = matplotlibcpp;
+
+const int N = 100;
+const double mean = 0.0;
+const double std_dev = 0.05;
+
+default_random_engine random_engine;
+normal_distribution<double> distribution(mean, std_dev);
+
+auto roll = [](){ return distribution(random_engine); };
+
+int main() {
+  Point true_center(1.0, -2.0);
+  Ellipse true_ellipse(true_center, 4.0, 2.0, M_PI / 6.0);
+
+  vector<Point> noisy_point_set;
+
+  for (size_t i = 0; i < N; ++i) {
+    Vec random_noise(roll(), roll());
+
+    double theta = -M_PI / 2.0 + 1.5 * M_PI * (double) i / (double) N;
+    Point ellipse_point = true_ellipse.createPointFromAngle(theta);
+
+    noisy_point_set.push_back(ellipse_point + random_noise);
+  }
+
+  Ellipse fitted_ellipse;
+  double variance;
+  try {
+    FigureFitter fitter(noisy_point_set);
+    fitter.fitEllipse(fitted_ellipse, variance);
+  }
+  catch (const exception& e) {
+    cout << e.what();
+    return 1;
+  }
+
+  cout << "Results of ellipse fitting" << endl;
+  cout << "Number of samples: " << N << endl;
+  cout << "Original ellipse: " << true_ellipse << endl;
+  cout << "Fitted ellipse: " << fitted_ellipse << endl;
+  cout << "Distance variance: " << variance << endl;
+
+  //
+  // Plot
+  //
+  vector<double> noisy_x_coords;
+  vector<double> noisy_y_coords;
+  for (auto& p : noisy_point_set) {
+    noisy_x_coords.push_back(p.x);
+    noisy_y_coords.push_back(p.y);
+  }
+
+  vector<double> true_ell_x_coords;
+  vector<double> true_ell_y_coords;
+  vector<double> fitted_ell_x_coords;
+  vector<double> fitted_ell_y_coords;
+  for (size_t i = 0; i <= 100; ++i) {
+    double angle = -M_PI + 2.0 * M_PI * i / 100.0;
+
+    Point p = true_ellipse.createPointFromAngle(angle);
+    true_ell_x_coords.push_back(p.x);
+    true_ell_y_coords.push_back(p.y);
+
+    p = fitted_ellipse.createPointFromAngle(angle);
+    fitted_ell_x_coords.push_back(p.x);
+    fitted_ell_y_coords.push_back(p.y);
+  }
+
+  double a = true_ellipse.semiMajorAxis();
+
+  double x_min = true_center.x - a - 3.0 * std_dev;
+  double x_max = true_center.x + a + 3.0 * std_dev;
+
+  double y_min = true_center.y - a - 3.0 * std_dev;
+  double y_max = true_center.y + a + 3.0 * std_dev;
+
+  plt::title("Ellipse fitting");
+  plt::xlabel("X coordinate");
+  plt::ylabel("Y coordinate");
+  plt::named_plot("Sample points", noisy_x_coords, noisy_y_coords, "kx");
+  plt::named_plot("True ellipse",
+                  true_ell_x_coords,
+                  true_ell_y_coords,
+                  "g-");
+
+  plt::named_plot("Fitted ellipse",
+                  fitted_ell_x_coords,
+                  fitted_ell_y_coords,
+                  "r-");
+
+  plt::named_plot("True center",
+                 {true_ellipse.center().x},
+                 {true_ellipse.center().y},
+                 "go");
+
+  plt::named_plot("Fitted center",
+                 {fitted_ellipse.center().x},
+                 {fitted_ellipse.center().y},
+                 "ro");
+
+  plt::legend();
+  plt::grid(true);
+  plt::xlim(x_min, x_max);
+  plt::ylim(y_min, y_max);
+  plt::show();
+}
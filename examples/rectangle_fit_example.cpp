@@ -0,0 +1,109 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+#include "../figures/rectangle.h"
+#include "../figure_fitter.h"
+#include "matplotlibcpp.h"
+
+using namespace std;
+using namespace figfit;
+namespace plt = matplotlibcpp;
+
+const int N = 100;
+const double mean = 0.0;
+const double std_dev = 0.03;
+
+default_random_engine random_engine;
+normal_distribution<double> distribution(mean, std_dev);
+
+auto roll = [](){ return distribution(random_engine); };
+
+int main() {
+  Point true_center(2.0, 5.0);
+  Rectangle true_rectangle(true_center, 4.5, 1.8, M_PI / 5.0);
+
+  // Only two sides of the rectangle (L-shape) are visible
+  Point corner = true_rectangle.corner(2);
+  Vec long_side = true_rectangle.corner(3) - corner;
+  Vec short_side = true_rectangle.corner(1) - corner;
+
+  vector<Point> noisy_point_set;
+
+  for (size_t i = 0; i < N; ++i) {
+    Vec random_noise(roll(), roll());
+
+    double t = 2.0 * (double) i / (double) N;
+    Point rectangle_point = (t < 1.0) ? corner + t * long_side :
+                                        corner + (t - 1.0) * short_side;
+
+    noisy_point_set.push_back(rectangle_point + random_noise);
+  }
+
+  Rectangle fitted_rectangle;
+  double variance;
+  try {
+    FigureFitter fitter(noisy_point_set);
+    fitter.fitRectangle(fitted_rectangle, variance);
+  }
+  catch (const exception& e) {
+    cout << e.what();
+    return 1;
+  }
+
+  cout << "Results of rectangle fitting" << endl;
+  cout << "Number of samples: " << N << endl;
+  cout << "Original rectangle: " << true_rectangle << endl;
+  cout << "Fitted rectangle: " << fitted_rectangle << endl;
+  cout << "Distance variance: " << variance << endl;
+
+  //
+  // Plot
+  //
+  vector<double> noisy_x_coords;
+  vector<double> noisy_y_coords;
+  for (auto& p : noisy_point_set) {
+    noisy_x_coords.push_back(p.x);
+    noisy_y_coords.push_back(p.y);
+  }
+
+  vector<double> true_rect_x_coords;
+  vector<double> true_rect_y_coords;
+  vector<double> fitted_rect_x_coords;
+  vector<double> fitted_rect_y_coords;
+  for (int i = 0; i <= 4; ++i) {
+    true_rect_x_coords.push_back(true_rectangle.corner(i).x);
+    true_rect_y_coords.push_back(true_rectangle.corner(i).y);
+
+    fitted_rect_x_coords.push_back(fitted_rectangle.corner(i).x);
+    fitted_rect_y_coords.push_back(fitted_rectangle.corner(i).y);
+  }
+
+  double size = true_rectangle.length();
+
+  double x_min = true_center.x - size / 2.0 - 3.0 * std_dev;
+  double x_max = true_center.x + size / 2.0 + 3.0 * std_dev;
+
+  double y_min = true_center.y - size / 2.0 - 3.0 * std_dev;
+  double y_max = true_center.y + size / 2.0 + 3.0 * std_dev;
+
+  plt::title("Rectangle fitting");
+  plt::xlabel("X coordinate");
+  plt::ylabel("Y coordinate");
+  plt::named_plot("Sample points", noisy_x_coords, noisy_y_coords, "kx");
+  plt::named_plot("True rectangle",
+                  true_rect_x_coords,
+                  true_rect_y_coords,
+                  "g-");
+
+  plt::named_plot("Fitted rectangle",
+                  fitted_rect_x_coords,
+                  fitted_rect_y_coords,
+                  "r-");
+
+  plt::legend();
+  plt::grid(true);
+  plt::xlim(x_min, x_max);
+  plt::ylim(y_min, y_max);
+  plt::show();
+}
@@ -18,7 +18,7 @@ const double std_dev = 0.1;
 default_random_engine random_engine;
 normal_distribution<double> distribution(mean, std_dev);
 
-auto roll = [&](){ return distribution(random_engine); };
+auto roll = [](){ return distribution(random_engine); };
 
 int main() {
   Point first_point(-2.0, 1.0);
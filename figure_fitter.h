@@ -1,14 +1,23 @@
 #pragma once
 
 #include <armadillo>
+#include <algorithm>
+#include <memory>
+#include <new>
 #include <vector>
 #include <stdexcept>
 
+#include "../fit_workspace.h"
+#include "../moments.h"
+#include "../point_cloud.h"
 #include "../figures/point.h"
 #include "../figures/line.h"
 #include "../figures/segment.h"
 #include "../figures/circle.h"
 #include "../figures/arc.h"
+#include "../figures/ellipse.h"
+#include "../figures/rectangle.h"
+#include "../figures/result.h"
 
 /*! \mainpage Figure Fitters 2D
  *
@@ -20,11 +29,25 @@
 namespace figfit
 {
 
+/**
+ * @brief Method of finding the end points of a fitted segment
+ *
+ * @sa FigureFitter::fitSegment()
+ */
+enum class SegmentExtent
+{
+  FirstLast,  /**< @brief Project the first and the last point of the set */
+  MinMax,     /**< @brief Span the extreme projections of all of the points */
+  Trimmed     /**< @brief Span the trimmed percentiles of the projections */
+};
+
 /** \class FigureFitter figure_fitter.h
  * \brief Class containing general fitting functionalities
  *
  * The class acts as a container for the point set, from which figures such as
- * point, line, line segment, circle or arc can be fitted.
+ * point, line, line segment, circle or arc can be fitted. A single fitter can
+ * be reused for many point sets with assign(), append() and clear(), which
+ * keep its storage and the moments cached by the previous fits.
  *
  * The class exploits Armadillo library for matrix operations and can throw any
  * of its exceptions (cf. www.arma.sourceforge.net).
@@ -36,6 +59,37 @@ public:
   //
   // Constructors
   //
+  /**
+   * @brief Constructor of empty fitter (default)
+   *
+   * The points can be loaded later with assign() or append().
+   */
+  FigureFitter() :
+    N_(0),
+    workspace_(&own_),
+    cache_(Cache::Cubic)
+  {
+    bind();
+  }
+
+  /**
+   * @brief Constructor of empty fitter with given workspace
+   *
+   * The fitter keeps its points and scratch buffers in the workspace. With a
+   * workspace that has already held as many points, neither loading points
+   * nor the fits allocate memory. The workspace must outlive the fitter and
+   * must not be shared by fitters in use at the same time.
+   *
+   * @param workspace is the workspace holding the points
+   */
+  explicit FigureFitter(FitWorkspace& workspace) :
+    N_(0),
+    workspace_(&workspace),
+    cache_(Cache::Cubic)
+  {
+    bind();
+  }
+
   /** \brief Constructor with given point set
    *
    * Copies x and y coordinates of the given point set into appropriate
@@ -44,14 +98,172 @@ public:
    * \param points is the vector containing figfig::Point objects
   */
   FigureFitter(const std::vector<Point>& points) :
-    N_(points.size()),
-    x_coords_(points.size()),
-    y_coords_(points.size())
+    FigureFitter()
   {
+    assign(points);
+  }
+
+  /**
+   * @brief Constructor with given point cloud
+   *
+   * Copies x and y coordinates of the points in the view into appropriate
+   * arma::vec objects and sets the size of the sample.
+   *
+   * @param points is the view of points, e.g. a PointCloud2D or its range
+   */
+  FigureFitter(const PointCloudView& points) :
+    FigureFitter()
+  {
+    assign(points);
+  }
+
+  /**
+   * @brief Constructor with given point cloud and workspace
+   *
+   * Copies x and y coordinates of the points into the workspace.
+   *
+   * @param points is the view of points, e.g. a PointCloud2D or its range
+   * @param workspace is the workspace holding the points
+   *
+   * @sa FigureFitter(FitWorkspace&)
+   */
+  FigureFitter(const PointCloudView& points, FitWorkspace& workspace) :
+    FigureFitter(workspace)
+  {
+    assign(points);
+  }
+
+  /**
+   * @brief Copy constructor
+   *
+   * The copy keeps the points in its own storage, even if the original uses
+   * a workspace.
+   */
+  FigureFitter(const FigureFitter& rhs) :
+    FigureFitter()
+  {
+    *this = rhs;
+  }
+
+  /**
+   * @brief Copy assignment
+   *
+   * Copies the points and the cached moments into the storage of this fitter.
+   */
+  FigureFitter& operator=(const FigureFitter& rhs) {
+    if (this != &rhs) {
+      assign(rhs.view());
+      moments_ = rhs.moments_;
+      cache_ = rhs.cache_;
+    }
+    return *this;
+  }
+
+  //
+  // Point set methods
+  //
+  /**
+   * @brief Replace the point set
+   *
+   * Reuses the storage of the fitter, which grows only when the new set is
+   * larger than any of the previous ones.
+   *
+   * @param points is the view of points, e.g. a PointCloud2D or its range
+   */
+  void assign(const PointCloudView& points) {
+    N_ = points.size();
+    reserve(N_);
+    std::copy(points.xData(), points.xData() + N_, workspace_->x_.data());
+    std::copy(points.yData(), points.yData() + N_, workspace_->y_.data());
+    bind();
+    cache_ = Cache::None;
+  }
+
+  /**
+   * @brief Replace the point set
+   *
+   * @param points is the vector containing figfit::Point objects
+   */
+  void assign(const std::vector<Point>& points) {
+    N_ = points.size();
+    reserve(N_);
     for (size_t i = 0; i < N_; ++i) {
-      x_coords_(i) = points[i].x;
-      y_coords_(i) = points[i].y;
+      workspace_->x_[i] = points[i].x;
+      workspace_->y_[i] = points[i].y;
     }
+    bind();
+    cache_ = Cache::None;
+  }
+
+  /**
+   * @brief Append points to the point set
+   *
+   * The storage grows geometrically. Moments cached by the previous fits are
+   * updated with the appended points instead of being recomputed. The view
+   * must not refer to the points of this fitter.
+   *
+   * @param points is the view of points, e.g. a PointCloud2D or its range
+   */
+  void append(const PointCloudView& points) {
+    const size_t n = points.size();
+    reserve(N_ + n);
+    std::copy(points.xData(), points.xData() + n, workspace_->x_.data() + N_);
+    std::copy(points.yData(), points.yData() + n, workspace_->y_.data() + N_);
+
+    if (cache_ == Cache::Cubic)
+      moments_.addBlock(points.xData(), points.yData(), n);
+    else if (cache_ == Cache::Moments)
+      moments_.Moments::addBlock(points.xData(), points.yData(), n);
+
+    N_ += n;
+    bind();
+  }
+
+  /**
+   * @brief Append point to the point set
+   *
+   * @param p is the appended point
+   *
+   * @sa append(const PointCloudView&)
+   */
+  void append(const Point& p) {
+    append(PointCloudView(&p.x, &p.y, 1));
+  }
+
+  /**
+   * @brief Remove all of the points but keep the storage
+   */
+  void clear() {
+    N_ = 0;
+    bind();
+    moments_ = CubicMoments();
+    cache_ = Cache::Cubic;
+  }
+
+  /**
+   * @brief Drop the moments cached by the previous fits
+   *
+   * The next fit recomputes them from the points, e.g. to measure the full
+   * cost of the fit.
+   */
+  void dropMoments() {
+    cache_ = Cache::None;
+  }
+
+  /**
+   * @brief Get number of points
+   */
+  size_t size() const {
+    return N_;
+  }
+
+  /**
+   * @brief Get view of the points
+   *
+   * The view is invalidated by the methods changing the point set.
+   */
+  PointCloudView view() const {
+    return PointCloudView(x_coords_.memptr(), y_coords_.memptr(), N_);
   }
 
   //
@@ -82,14 +294,20 @@ public:
    * @brief Fit line from the point set
    *
    * Uses linear regression with the general line model Ax + By + C = 0. C is
-   * set to -1 and A, B are the result of [A B] = pinv([x y]) * [C]. Here
-   * pinv() is the Moore - Penrose pseudo inverse, [x y] and [C] denote matrix
-   * and vector with N rows (N being the sample size).
+   * set to -1 and A, B are the least squares solution of [x y] [A B]' = [1],
+   * where [x y] and [1] denote matrix and vector with N rows (N being the
+   * sample size). The 2x2 normal equations are built from the moments of
+   * the points, hence the fit does not allocate memory. If they are singular,
+   * e.g. for identical points, the minimum norm solution is taken as with the
+   * pseudo inverse.
    *
    * Note that this method is inappropriate for fitting lines crossing point
    * (0,0) (in such case C = 0).
    *
    * @param l is a placeholder for the resulting line
+   *
+   * @throw std::logic_error if there are less than two points in the set
+   * @throw std::runtime_error if the line cannot be determined
    */
   void fitLine(Line& l);
 
@@ -111,6 +329,10 @@ public:
    * last points of the set onto this line in order to obtain the segment.
    *
    * @param s is a placeholder for the resulting segment
+   *
+   * @throw std::logic_error if there are less than two points in the set or
+   * the first and last points project onto one point
+   * @throw std::runtime_error if the line cannot be determined
    */
   void fitSegment(Segment& s);
 
@@ -125,16 +347,63 @@ public:
    */
   void fitSegment(Segment& s, double& variance);
 
+  /**
+   * @brief Fit segment from the point set with given end points method
+   *
+   * Performs the line fitting with fitLine() method and then projects all of
+   * the points onto this line in one pass. For SegmentExtent::MinMax the
+   * segment spans the extreme projections, so that the result does not depend
+   * on the order of points. For SegmentExtent::Trimmed the segment spans the
+   * projections at percentiles trim and (1 - trim), which rejects noisy end
+   * points. The segment is directed from the first towards the last point of
+   * the set.
+   *
+   * @param s is a placeholder for the resulting segment
+   * @param extent is the method of finding the end points
+   * @param trim is the fraction of projections dropped at each end, in range
+   * [0, 0.5), used only with SegmentExtent::Trimmed
+   *
+   * @throw std::logic_error if trim is out of range or, for
+   * SegmentExtent::FirstLast, the first and last points project onto one point
+   * @throw std::runtime_error if all of the points project onto one point
+   */
+  void fitSegment(Segment& s, SegmentExtent extent, double trim = 0.05);
+
+  /**
+   * @brief Fit segment from the point set with given end points method and get
+   * variance
+   *
+   * The variance is accumulated in the same pass as the projections. Points
+   * projecting outside of the trimmed segment contribute their squared
+   * distance to the nearest end point.
+   *
+   * @param s is a placeholder for the resulting segment
+   * @param variance is a placeholder for the resulting variance
+   * @param extent is the method of finding the end points
+   * @param trim is the fraction of projections dropped at each end, in range
+   * [0, 0.5), used only with SegmentExtent::Trimmed
+   *
+   * @sa fitSegment(Segment&, SegmentExtent, double)
+   */
+  void fitSegment(Segment& s, double& variance, SegmentExtent extent,
+                  double trim = 0.05);
+
   /**
    * @brief Fit circle from the point set
    *
    * Uses linear regression to compute the parameters (center point and radius)
    * of the circle. The general circle equation (x - x0)^2 + (y - y0)^2 = r^2 is
    * turned into a1 * x + a2 * y + a3 = (x^2 + y^2) / 2, where a1 = x0, a2 = y0
-   * and a3 = -(x0^2 + y0^2 - r^2) / 2. With such form the parameters can be
-   * obtained from [a1 a2 a3] = pinv([x y 1]) * [x^2 + y^2] / 2
+   * and a3 = -(x0^2 + y0^2 - r^2) / 2. With such form the parameters are the
+   * least squares solution of [x y 1] [a1 a2 a3]' = [x^2 + y^2] / 2. The
+   * normal equations are solved in the frame of the centroid, where they
+   * depend only on the moments of the points up to the third order, hence
+   * the fit does not allocate memory.
    *
    * @param c is a placeholder for the resulting circle
+   *
+   * @throw std::runtime_error if there are less than three points in the set
+   * or all of the points are collinear
    */
   void fitCircle(Circle& c);
 
@@ -149,6 +418,467 @@ public:
    */
   void fitCircle(Circle& c, double& variance);
 
+  /**
+   * @brief Fit circle of known radius from the point set
+   *
+   * Only the center of the circle is estimated. The initial center is placed
+   * in closed form: its direction from the centroid of points is taken from
+   * the algebraic fit of fitCircle() and its distance from the centroid d
+   * follows from r^2 = s^2 + d^2, where s^2 is the mean squared distance of
+   * points from their centroid. The center is then refined with a few Gauss-
+   * Newton steps minimizing the sum of (|p_i - center| - r)^2.
+   *
+   * For collinear points the center is placed on the side of the points
+   * facing away from (0,0), i.e. the side of the sensor origin is assumed to
+   * be convex.
+   *
+   * @param c is a placeholder for the resulting circle
+   * @param radius is the known radius of the circle
+   *
+   * @throw std::runtime_error if there are less than two points in the set
+   */
+  void fitCircleOfRadius(Circle& c, double radius);
+
+  /**
+   * @brief Fit circle of known radius from the point set and get variance
+   *
+   * Performs the circle fitting with fitCircleOfRadius() method and then
+   * calculates the variance of points around obtained figure.
+   *
+   * @param c is a placeholder for the resulting circle
+   * @param radius is the known radius of the circle
+   * @param variance is a placeholder for the resulting variance
+   */
+  void fitCircleOfRadius(Circle& c, double radius, double& variance);
+
+  /**
+   * @brief Fit circle of known radius from the cluttered point set
+   *
+   * Uses RANSAC: each hypothesis is drawn from two random points, which with
+   * known radius give at most two candidate centers. The candidate with the
+   * most inliers, i.e. points closer to the circumference than the threshold,
+   * is refined with Gauss-Newton steps over its inliers only. The inlier test
+   * compares squared distances to the center, hence no square roots are taken
+   * while scoring. The random generator is seeded with a constant, so that the
+   * result is repeatable.
+   *
+   * @param c is a placeholder for the resulting circle
+   * @param radius is the known radius of the circle
+   * @param threshold is the maximal distance of inliers from the circumference
+   * @param hypotheses is the number of drawn pairs of points
+   *
+   * @throw std::runtime_error if there are less than two points in the set or
+   * no hypothesis could be created
+   */
+  void fitCircleOfRadiusRobust(Circle& c, double radius, double threshold,
+                               size_t hypotheses = 64);
+
+  /**
+   * @brief Fit circle of known radius from the cluttered point set and get
+   * variance
+   *
+   * Performs the circle fitting with fitCircleOfRadiusRobust() method and then
+   * calculates the variance of inliers around obtained figure.
+   *
+   * @param c is a placeholder for the resulting circle
+   * @param radius is the known radius of the circle
+   * @param threshold is the maximal distance of inliers from the circumference
+   * @param variance is a placeholder for the resulting variance of inliers
+   * @param hypotheses is the number of drawn pairs of points
+   */
+  void fitCircleOfRadiusRobust(Circle& c, double radius, double threshold,
+                               double& variance, size_t hypotheses = 64);
+
+  /**
+   * @brief Fit ellipse from the point set
+   *
+   * Uses the direct least squares fit of A. Fitzgibbon et al. in the
+   * numerically stable formulation of R. Halir and J. Flusser. The points are
+   * first centered and scaled. The 6x6 scatter matrix of the conic terms
+   * [x^2, xy, y^2, x, y, 1] is accumulated in a single pass from 15 sums of
+   * monomials. It is then reduced to a 3x3 eigenproblem, which is solved in
+   * closed form. The eigenvector satisfying the ellipse constraint
+   * 4AC - B^2 > 0 gives the conic.
+   *
+   * @param e is a placeholder for the resulting ellipse
+   *
+   * @throw std::runtime_error if there are less than five points in the set
+   * or the points do not determine an ellipse
+   */
+  void fitEllipse(Ellipse& e);
+
+  /**
+   * @brief Fit ellipse from the point set and get variance
+   *
+   * Performs the ellipse fitting with fitEllipse() method and then calculates
+   * the variance of points around obtained figure. Note that the variance uses
+   * the approximated Ellipse::distanceSquaredTo().
+   *
+   * @param e is a placeholder for the resulting ellipse
+   * @param variance is a placeholder for the resulting variance
+   */
+  void fitEllipse(Ellipse& e, double& variance);
+
+  /**
+   * @brief Fit rectangle from the point set
+   *
+   * Fits an oriented rectangle to an L-shaped (or fully visible) point set,
+   * e.g. a vehicle or a pallet. For each candidate orientation the points are
+   * projected onto the two axes and bounded. The orientation minimizes the
+   * sum of squared distances of points to the nearest of the bounding sides
+   * (the closeness criterion). The orientation is searched coarse-to-fine in
+   * range [0, pi/2): a coarse grid is followed by a few levels of four times
+   * finer grids around the best angle, so the cost is a few dozen passes over
+   * the points regardless of the required angular resolution.
+   *
+   * @param r is a placeholder for the resulting rectangle
+   *
+   * @throw std::runtime_error if there are less than three points in the set
+   */
+  void fitRectangle(Rectangle& r);
+
+  /**
+   * @brief Fit rectangle from the point set and get variance
+   *
+   * Performs the rectangle fitting with fitRectangle() method and then
+   * calculates the variance of points around obtained figure.
+   *
+   * @param r is a placeholder for the resulting rectangle
+   * @param variance is a placeholder for the resulting variance
+   */
+  void fitRectangle(Rectangle& r, double& variance);
+
+  //
+  // Constrained fitting methods
+  //
+  /**
+   * @brief Fit parallel lines from several point sets
+   *
+   * Fits one line to each of the point sets, such that all of the lines share
+   * a common direction. Uses orthogonal regression: each line passes through
+   * the centroid of its set and the common normal is the eigenvector of the
+   * smallest eigenvalue of the summed scatter matrices. The solution is closed
+   * form and depends on the point sets only through their moments, hence the
+   * sets are given by the moments, e.g. found by findMoments() of the fitters
+   * or merged from chunks, and their points are not copied.
+   *
+   * @param moments are the moments of the point sets, one per line
+   * @param lines is a placeholder for the resulting lines, any vector of
+   * lines, e.g. LineArray or pmr::LineArray
+   *
+   * @throw std::logic_error if any of the point sets is empty
+   * @throw std::runtime_error if the points do not determine a direction
+   */
+  template <typename LineAllocator>
+  static void fitParallelLines(const std::vector<Moments>& moments,
+                               std::vector<Line, LineAllocator>& lines) {
+    check(tryFitParallelLines(moments, lines), "lines", true);
+  }
+
+  /**
+   * @brief Fit parallel lines from several point sets and get variances
+   *
+   * @param moments are the moments of the point sets, one per line
+   * @param lines is a placeholder for the resulting lines
+   * @param variances is a placeholder for the variances of points around each
+   * of the resulting lines, any vector of doubles
+   *
+   * @sa fitParallelLines()
+   */
+  template <typename LineAllocator, typename VarianceAllocator>
+  static void fitParallelLines(
+      const std::vector<Moments>& moments,
+      std::vector<Line, LineAllocator>& lines,
+      std::vector<double, VarianceAllocator>& variances) {
+    check(tryFitParallelLines(moments, lines, variances), "lines", true);
+  }
+
+  /**
+   * @brief Fit two perpendicular lines from two point sets
+   *
+   * Uses orthogonal regression with the constraint that the lines are
+   * perpendicular, e.g. for two walls meeting at a corner. The solution is
+   * closed form.
+   *
+   * @param first is the fitter containing the point set of the first line
+   * @param second is the fitter containing the point set of the second line
+   * @param l1 is a placeholder for the first resulting line
+   * @param l2 is a placeholder for the second resulting line
+   *
+   * @throw std::logic_error if any of the point sets is empty
+   * @throw std::runtime_error if the points do not determine a direction
+   */
+  static void fitPerpendicularLines(const FigureFitter& first,
+                                    const FigureFitter& second,
+                                    Line& l1, Line& l2);
+
+  /**
+   * @brief Fit two perpendicular lines from two point sets and get variances
+   *
+   * @param first is the fitter containing the point set of the first line
+   * @param second is the fitter containing the point set of the second line
+   * @param l1 is a placeholder for the first resulting line
+   * @param l2 is a placeholder for the second resulting line
+   * @param variance1 is a placeholder for the variance around the first line
+   * @param variance2 is a placeholder for the variance around the second line
+   *
+   * @sa fitPerpendicularLines()
+   */
+  static void fitPerpendicularLines(const FigureFitter& first,
+                                    const FigureFitter& second,
+                                    Line& l1, Line& l2,
+                                    double& variance1, double& variance2);
+
+  /**
+   * @brief Fit lines aligned with a common rectangular grid
+   *
+   * Fits one line to each of the point sets, such that every line is either
+   * parallel or perpendicular to every other line (Manhattan world). The
+   * dominant grid angle is the weighted circular mean of the principal angles
+   * of the sets taken modulo pi/2, where the weights are the anisotropies of
+   * the sets. Each set is then assigned to the closer of the two grid axes and
+   * the joint orthogonal regression is solved in closed form.
+   *
+   * @param moments are the moments of the point sets, one per line
+   * @param lines is a placeholder for the resulting lines, any vector of
+   * lines, e.g. LineArray or pmr::LineArray
+   *
+   * @throw std::logic_error if any of the point sets is empty
+   * @throw std::runtime_error if the points do not determine a direction
+   *
+   * @sa fitParallelLines()
+   */
+  template <typename LineAllocator>
+  static void fitManhattanLines(const std::vector<Moments>& moments,
+                                std::vector<Line, LineAllocator>& lines) {
+    check(tryFitManhattanLines(moments, lines), "lines", true);
+  }
+
+  /**
+   * @brief Fit lines aligned with a common rectangular grid and get variances
+   *
+   * @param moments are the moments of the point sets, one per line
+   * @param lines is a placeholder for the resulting lines
+   * @param variances is a placeholder for the variances of points around each
+   * of the resulting lines, any vector of doubles
+   *
+   * @sa fitManhattanLines()
+   */
+  template <typename LineAllocator, typename VarianceAllocator>
+  static void fitManhattanLines(
+      const std::vector<Moments>& moments,
+      std::vector<Line, LineAllocator>& lines,
+      std::vector<double, VarianceAllocator>& variances) {
+    check(tryFitManhattanLines(moments, lines, variances), "lines", true);
+  }
+
+  /**
+   * @brief Fit line to a point set given by its moments
+   *
+   * The normal equations of fitLine() depend on the points only through their
+   * moments, hence the resulting line is the same. They are solved in the
+   * centered form, which stays accurate for large point sets located far
+   * from (0, 0). Useful with moments merged from many chunks of points.
+   *
+   * @param m is the moments of the point set
+   * @param l is a placeholder for the resulting line
+   *
+   * @throw std::logic_error if there are less than two points in the set
+   * @throw std::runtime_error if the line cannot be determined
+   */
+  static void fitLine(const Moments& m, Line& l);
+
+  /**
+   * @brief Fit line to a point set given by its moments and get variance
+   *
+   * @param m is the moments of the point set
+   * @param l is a placeholder for the resulting line
+   * @param variance is a placeholder for the variance of points around line
+   *
+   * @sa fitLine(const Moments&, Line&)
+   */
+  static void fitLine(const Moments& m, Line& l, double& variance);
+
+  /**
+   * @brief Fit circle to a point set given by its moments
+   *
+   * Solves the normal equations of fitCircle() in the frame of the centroid,
+   * where they depend only on the second and third order moments. The
+   * variance about a circle is not a function of the moments and must be
+   * found with another pass over the points.
+   *
+   * @param m is the moments of the point set
+   * @param c is a placeholder for the resulting circle
+   *
+   * @throw std::runtime_error if there are less than three points in the set
+   * or all of the points are collinear
+   */
+  static void fitCircle(const CubicMoments& m, Circle& c);
+
+  //
+  // Non-throwing fitting methods
+  //
+  /**
+   * @brief Try to fit point from the point set
+   *
+   * The try-methods perform the same fits as their throwing counterparts, but
+   * report a failure with the returned status instead of an exception. They
+   * do not allocate memory on the failure path and leave the placeholders
+   * unchanged unless the status is FitStatus::Ok, which makes them suitable
+   * for loops over many clusters where failures are expected.
+   *
+   * @param p is a placeholder for the resulting point
+   *
+   * @return FitStatus::TooFewPoints if the set is empty
+   *
+   * @sa fitPoint()
+   */
+  FitStatus tryFitPoint(Point& p);
+  FitStatus tryFitPoint(Point& p, double& variance);
+
+  /**
+   * @brief Try to fit line from the point set
+   *
+   * @return FitStatus::TooFewPoints or FitStatus::NoSolution if the line
+   * crosses (0,0)
+   *
+   * @sa fitLine(), tryFitPoint()
+   */
+  FitStatus tryFitLine(Line& l);
+  FitStatus tryFitLine(Line& l, double& variance);
+
+  /**
+   * @brief Try to fit segment from the point set
+   *
+   * @return status of tryFitLine(), FitStatus::InvalidArgument if trim is out
+   * of range or FitStatus::Degenerate if the points project onto one point
+   *
+   * @sa fitSegment(), tryFitPoint()
+   */
+  FitStatus tryFitSegment(Segment& s);
+  FitStatus tryFitSegment(Segment& s, double& variance);
+  FitStatus tryFitSegment(Segment& s, SegmentExtent extent,
+                          double trim = 0.05);
+  FitStatus tryFitSegment(Segment& s, double& variance, SegmentExtent extent,
+                          double trim = 0.05);
+
+  /**
+   * @brief Try to fit circle from the point set
+   *
+   * @return FitStatus::TooFewPoints or FitStatus::Collinear
+   *
+   * @sa fitCircle(), tryFitPoint()
+   */
+  FitStatus tryFitCircle(Circle& c);
+  FitStatus tryFitCircle(Circle& c, double& variance);
+
+  /**
+   * @brief Try to fit circle of known radius from the point set
+   *
+   * @return FitStatus::TooFewPoints
+   *
+   * @sa fitCircleOfRadius(), tryFitPoint()
+   */
+  FitStatus tryFitCircleOfRadius(Circle& c, double radius);
+  FitStatus tryFitCircleOfRadius(Circle& c, double radius, double& variance);
+
+  /**
+   * @brief Try to fit circle of known radius from the cluttered point set
+   *
+   * @return FitStatus::TooFewPoints or FitStatus::NoSolution if no hypothesis
+   * could be created
+   *
+   * @sa fitCircleOfRadiusRobust(), tryFitPoint()
+   */
+  FitStatus tryFitCircleOfRadiusRobust(Circle& c, double radius,
+                                       double threshold,
+                                       size_t hypotheses = 64);
+  FitStatus tryFitCircleOfRadiusRobust(Circle& c, double radius,
+                                       double threshold, double& variance,
+                                       size_t hypotheses = 64);
+
+  /**
+   * @brief Try to fit ellipse from the point set
+   *
+   * @return FitStatus::TooFewPoints, FitStatus::Degenerate if the points are
+   * identical, FitStatus::Collinear or FitStatus::NoSolution if the points do
+   * not determine an ellipse
+   *
+   * @sa fitEllipse(), tryFitPoint()
+   */
+  FitStatus tryFitEllipse(Ellipse& e);
+  FitStatus tryFitEllipse(Ellipse& e, double& variance);
+
+  /**
+   * @brief Try to fit rectangle from the point set
+   *
+   * @return FitStatus::TooFewPoints
+   *
+   * @sa fitRectangle(), tryFitPoint()
+   */
+  FitStatus tryFitRectangle(Rectangle& r);
+  FitStatus tryFitRectangle(Rectangle& r, double& variance);
+
+  /**
+   * @brief Try to fit lines from several point sets under constraints
+   *
+   * @return FitStatus::TooFewPoints if any of the point sets is empty or
+   * FitStatus::Degenerate if the points do not determine a direction
+   *
+   * @sa fitParallelLines(), fitPerpendicularLines(), fitManhattanLines()
+   */
+  template <typename LineAllocator>
+  static FitStatus tryFitParallelLines(
+      const std::vector<Moments>& moments,
+      std::vector<Line, LineAllocator>& lines) {
+    return fitLinesOnGrid(moments, false, lines,
+                          static_cast<std::vector<double>*>(nullptr));
+  }
+
+  template <typename LineAllocator, typename VarianceAllocator>
+  static FitStatus tryFitParallelLines(
+      const std::vector<Moments>& moments,
+      std::vector<Line, LineAllocator>& lines,
+      std::vector<double, VarianceAllocator>& variances) {
+    return fitLinesOnGrid(moments, false, lines, &variances);
+  }
+
+  static FitStatus tryFitPerpendicularLines(const FigureFitter& first,
+                                            const FigureFitter& second,
+                                            Line& l1, Line& l2);
+  static FitStatus tryFitPerpendicularLines(const FigureFitter& first,
+                                            const FigureFitter& second,
+                                            Line& l1, Line& l2,
+                                            double& variance1,
+                                            double& variance2);
+
+  template <typename LineAllocator>
+  static FitStatus tryFitManhattanLines(
+      const std::vector<Moments>& moments,
+      std::vector<Line, LineAllocator>& lines) {
+    return fitLinesOnGrid(moments, true, lines,
+                          static_cast<std::vector<double>*>(nullptr));
+  }
+
+  template <typename LineAllocator, typename VarianceAllocator>
+  static FitStatus tryFitManhattanLines(
+      const std::vector<Moments>& moments,
+      std::vector<Line, LineAllocator>& lines,
+      std::vector<double, VarianceAllocator>& variances) {
+    return fitLinesOnGrid(moments, true, lines, &variances);
+  }
+
+  /**
+   * @brief Try to fit line or circle to a point set given by its moments
+   *
+   * @return statuses as tryFitLine() and tryFitCircle()
+   *
+   * @sa fitLine(const Moments&, Line&), fitCircle(const CubicMoments&, Circle&)
+   */
+  static FitStatus tryFitLine(const Moments& m, Line& l);
+  static FitStatus tryFitLine(const Moments& m, Line& l, double& variance);
+  static FitStatus tryFitCircle(const CubicMoments& m, Circle& c);
+
   //  void fitArc(Arc &arc);
   //  void fitArc(Arc &arc, double &variance);
 
@@ -171,8 +901,63 @@ public:
     return y_coords_;
   }
 
+  /**
+   * @brief Get scatter moments
+   *
+   * Computes the centroid in the first pass and the centered sums of products
+   * in the second pass. The moments are cached until the point set is
+   * replaced, hence fitting several figures to one set computes them once.
+   * Due to the cache the fitter must not be used by several threads at once,
+   * even through const methods.
+   *
+   * @return scatter moments of the point set
+   */
+  Moments findMoments() const;
+
+  /**
+   * @brief Get scatter moments up to the third order
+   *
+   * @return scatter moments of the point set
+   *
+   * @sa findMoments()
+   */
+  CubicMoments findCubicMoments() const;
+
 private:
 
+  /**
+   * @brief Order of the cached moments
+   */
+  enum class Cache
+  {
+    None,     /**< @brief No moments are cached */
+    Moments,  /**< @brief Moments up to the second order are cached */
+    Cubic     /**< @brief Moments up to the third order are cached */
+  };
+
+  /**
+   * @brief Grow storage of points to given size, keeping the points
+   */
+  void reserve(size_t size) {
+    if (size > workspace_->capacity())
+      workspace_->reserve(std::max(size, 2 * workspace_->capacity()));
+  }
+
+  /**
+   * @brief Point coordinate vectors at the storage of points
+   *
+   * Armadillo vectors cannot be redirected to other memory, hence they are
+   * recreated in place as aliases of the storage.
+   */
+  void bind() {
+    double* x = workspace_->x_.data();
+    double* y = workspace_->y_.data();
+    std::destroy_at(&x_coords_);
+    new (&x_coords_) arma::vec(x, N_, false, false);
+    std::destroy_at(&y_coords_);
+    new (&y_coords_) arma::vec(y, N_, false, false);
+  }
+
   /**
    * @brief Find variance of points about given figure
    *
@@ -191,105 +976,220 @@ private:
     return var / N_;
   }
 
-  size_t N_;            /**< Number of point (sample size) */
-  arma::vec x_coords_;  /**< Vector containing x coordinates of points */
-  arma::vec y_coords_;  /**< Vector containing y coordinates of points */
-};
-
-
-void FigureFitter::fitPoint(Point& p) {
-  if (N_ < 1)
-    throw std::logic_error("Error while fitting point. There must be at least "
-                           "one point in the set.");
-
-  double mean_x = mean(x_coords_);
-  double mean_y = mean(y_coords_);
-
-  p = Point(mean_x, mean_y);
-}
+  /**
+   * @brief Find variance of points about given line
+   *
+   * Gives the variance of findVarianceAbout() with the vectorized kernel.
+   */
+  double findVarianceAboutLine(const Line& l) const;
 
-void FigureFitter::fitPoint(Point& p, double& variance) {
-  fitPoint(p);
-  variance = findVarianceAbout(p);
-}
+  /**
+   * @brief Find variance of points about given circle
+   *
+   * Gives the variance of findVarianceAbout() with the vectorized kernel.
+   */
+  double findVarianceAboutCircle(const Circle& c) const;
 
-void FigureFitter::fitLine(Line& l) {
-  if (N_ < 2)
-    throw std::logic_error("Error while fitting line. There must be at least "
-                           "two points in the set.");
+  /**
+   * @brief Find segment spanning the projections of points onto given line
+   *
+   * Computes the projection parameters and squared distances of all of the
+   * points to the line in one pass. For SegmentExtent::Trimmed the parameters
+   * are stored in a reusable buffer and the percentiles are selected with
+   * std::nth_element.
+   *
+   * @param line is the supporting line of the segment
+   * @param extent is the method of finding the end points
+   * @param trim is the fraction of projections dropped at each end
+   * @param s is a placeholder for the resulting segment
+   *
+   * @param sum is a placeholder for the sum of squared distances of points to
+   * the resulting segment
+   *
+   * @return FitStatus::InvalidArgument if trim is out of range or
+   * FitStatus::Degenerate if all of the points project onto one point
+   */
+  FitStatus findSegmentAlong(const Line& line, SegmentExtent extent,
+                             double trim, Segment& s, double& sum);
 
-  arma::mat input  = arma::mat(N_, 2);      // [x_i, y_i]
-  arma::vec output = arma::vec(N_).ones();  // [-C]
-  arma::vec params = arma::vec(2);          // [A ; B]
+  /**
+   * @brief Try to fit segment with given end points method
+   *
+   * Shared by both of the tryFitSegment() overloads taking the extent.
+   *
+   * @param find_variance tells whether the variance is needed
+   */
+  FitStatus tryFitSegment(Segment& s, double& variance, SegmentExtent extent,
+                          double trim, bool find_variance);
 
-  input.col(0) = x_coords_;
-  input.col(1) = y_coords_;
+  /**
+   * @brief Refine center of circle of known radius
+   *
+   * Performs Gauss-Newton steps for the center, taking into account only the
+   * points closer to the circumference than the threshold.
+   *
+   * @param center is the center to be refined
+   * @param radius is the known radius of the circle
+   * @param threshold is the maximal distance of considered points from the
+   * circumference
+   *
+   * @return sum of squared distances of considered points to the circle and
+   * their number
+   */
+  std::pair<double, size_t> refineCenter(Point& center, double radius,
+                                         double threshold) const;
 
-  params = arma::pinv(input) * output;
+  /**
+   * @brief Fit parallel lines or lines aligned with a rectangular grid
+   *
+   * Minimizes the sum of squared distances of points to their lines, where
+   * the lines of sets assigned to axis 0 share a direction d and the lines of
+   * sets assigned to axis 1 share the direction perpendicular to d. Since the
+   * residual of an axis 1 set is the residual of its scatter matrix rotated by
+   * 90 deg, the problem reduces to a single 2x2 eigenproblem, which needs no
+   * scratch memory.
+   *
+   * @param moments are the moments of the point sets, one per line
+   * @param manhattan if true, sets are assigned to the closer axis of the
+   * dominant grid, otherwise all of them to axis 0
+   * @param lines is a placeholder for the resulting lines
+   * @param variances is a placeholder for the resulting variances or nullptr
+   *
+   * @return statuses as tryFitParallelLines()
+   */
+  template <typename Lines, typename Variances>
+  static FitStatus fitLinesOnGrid(const std::vector<Moments>& moments,
+                                  bool manhattan, Lines& lines,
+                                  Variances* variances) {
+    for (const Moments& m : moments)
+      if (m.n < 1)
+        return FitStatus::TooFewPoints;
 
-  if (params(0) == 0 && params(1) == 0)
-    throw std::runtime_error("Error while fitting line");
+    const double grid_angle = manhattan ? findGridAngle(moments) : 0.0;
 
-  l = Line(params(0), params(1), -1.0);
-}
+    Moments joint;
+    for (const Moments& m : moments)
+      addOnAxis(m, manhattan ? findGridAxis(m, grid_angle) : 0, joint);
 
-void FigureFitter::fitLine(Line& l, double& variance) {
-  fitLine(l);
-  variance = findVarianceAbout(l);
-}
+    Vec direction;
+    FitStatus status = findJointDirection(joint, direction);
+    if (status != FitStatus::Ok)
+      return status;
 
-void FigureFitter::fitSegment(Segment& s) {
-  Line line;
-  fitLine(line);
+    lines.clear();
+    if (variances)
+      variances->clear();
 
-  Point first_point(x_coords_(0), y_coords_(0));
-  Point second_point(x_coords_(N_ - 1), y_coords_(N_ - 1));
+    // The axes are found again instead of being stored
+    for (const Moments& m : moments) {
+      bool on_axis_1 = manhattan && findGridAxis(m, grid_angle) == 1;
+      Vec d = on_axis_1 ? direction.rotated90() : direction;
 
-  first_point = line.findProjectionOf(first_point);
-  second_point = line.findProjectionOf(second_point);
+      double variance;
+      lines.push_back(findLineAlong(m, d, variance));
+      if (variances)
+        variances->push_back(variance);
+    }
 
-  s = Segment(first_point, second_point);
-}
+    return FitStatus::Ok;
+  }
 
-void FigureFitter::fitSegment(Segment& s, double& variance) {
-  fitSegment(s);
-  variance = findVarianceAbout(s);
+  /**
+   * @brief Find dominant angle of the grid of point sets, modulo pi/2
+   *
+   * The angle is the weighted circular mean of the principal angles of the
+   * sets, where the weights are the anisotropies of the sets.
+   */
+  static double findGridAngle(const std::vector<Moments>& moments);
 
-//  // TODO: Experiment with that
-//  if (sqrt(variance) < 0.5 * s.length()) {
-//    Point new_start_point = s.createPointFromParam(sqrt(variance) / s.length());
-//    Point new_end_point = s.createPointFromParam(1.0 - sqrt(variance) / s.length());
+  /**
+   * @brief Find axis (0 or 1) of the grid closer to the principal angle of
+   * a point set
+   */
+  static int findGridAxis(const Moments& m, double grid_angle);
 
-//    s = Segment(new_start_point, new_end_point);
-//  }
-}
+  /**
+   * @brief Add scatter of a point set to the joint scatter of given axis
+   */
+  static void addOnAxis(const Moments& m, int axis, Moments& joint);
 
-void FigureFitter::fitCircle(Circle& c) {
-  if (N_ < 3)
-    throw std::runtime_error("Error while fitting circle. There must be at "
-                             "least three points in the set.");
+  /**
+   * @brief Find common direction of axis 0 from the joint scatter
+   *
+   * @return FitStatus::Degenerate if the joint scatter has no principal
+   * direction, e.g. every set is a single point
+   */
+  static FitStatus findJointDirection(const Moments& joint, Vec& direction);
 
-  arma::mat input  = arma::mat(N_, 3);   // [x_i, y_i, 1]
-  arma::vec output = arma::vec(N_);      // [(x_i^2 + y_i^2) / 2.0]
-  arma::vec params = arma::vec(3);       // [a_1 ; a_2 ; a_3]
+  /**
+   * @brief Find line of given direction through the centroid of a point set
+   *
+   * @param m is the moments of the point set
+   * @param d is the unit direction of the line
+   * @param variance is a placeholder for the variance of points around line
+   *
+   * @return resulting line
+   */
+  static Line findLineAlong(const Moments& m, const Vec& d, double& variance);
 
-  input.col(0) = x_coords_;
-  input.col(1) = y_coords_;
-  input.col(2) = arma::vec(N_).ones();
+  /**
+   * @brief Throw exception describing a failed fit
+   *
+   * The fits of points and lines have always treated too few points as
+   * misuse, hence they report FitStatus::TooFewPoints as std::logic_error.
+   * The segment fit has also reported the end points projecting onto one
+   * point as std::logic_error.
+   *
+   * @param status is the status of the fit
+   * @param figure is the name of the fitted figure
+   * @param too_few_is_logic_error if true, FitStatus::TooFewPoints is
+   * reported as std::logic_error
+   * @param degenerate_is_logic_error if true, FitStatus::Degenerate is
+   * reported as std::logic_error
+   *
+   * @throw std::logic_error for FitStatus::InvalidArgument and, if requested,
+   * for FitStatus::TooFewPoints and FitStatus::Degenerate
+   * @throw std::runtime_error for the other failures
+   */
+  static void check(FitStatus status, const char* figure,
+                    bool too_few_is_logic_error = false,
+                    bool degenerate_is_logic_error = false);
 
-  output = (arma::square(x_coords_) + arma::square(y_coords_)) / 2.0;
+  /**
+   * @brief Find eigenvector of a 3x3 matrix satisfying the ellipse constraint
+   *
+   * Finds the real eigenvalues of m from its characteristic polynomial and
+   * for each of them computes the eigenvector as the largest cross product of
+   * rows of (m - lambda * I). Returns the eigenvector [A, B, C] for which
+   * 4AC - B^2 is positive and greatest.
+   *
+   * @param m is the row-major 3x3 matrix
+   * @param v is a placeholder for the resulting eigenvector
+   *
+   * @return true if such an eigenvector was found
+   */
+  static bool findEllipticEigenvector(const double m[3][3], double v[3]);
 
-  params = arma::pinv(input) * output;
+  /**
+   * @brief Evaluate the closeness criterion of the rectangle at given angle
+   *
+   * @param theta is the orientation of the rectangle
+   * @param bounds is a placeholder for the bounds of projections onto the axes
+   * of the rectangle: [min_1, max_1, min_2, max_2]
+   *
+   * @return sum of squared distances of points to the nearest bounding side
+   */
+  double findRectangleCost(double theta, double bounds[4]) const;
 
-  Point center(params(0), params(1));
-  double radius = sqrt(pow(params(0), 2.0) + pow(params(1), 2.0) + 2.0 * params(2));
+  size_t N_;            /**< Number of point (sample size) */
+  arma::vec x_coords_;  /**< Vector containing x coordinates of points */
+  arma::vec y_coords_;  /**< Vector containing y coordinates of points */
 
-  c = Circle(center, radius);
-}
+  FitWorkspace own_;          /**< Storage used when no workspace is given */
+  FitWorkspace* workspace_;   /**< Storage of points and scratch buffers */
 
-void FigureFitter::fitCircle(Circle& c, double& variance) {
-  fitCircle(c);
-  variance = findVarianceAbout(c);
-}
+  mutable CubicMoments moments_;  /**< Cached moments of the point set */
+  mutable Cache cache_;           /**< Order of the cached moments */
+};
 
 } // end namespace figfit
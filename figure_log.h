@@ -0,0 +1,517 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../mapped_file.h"
+#include "../point_cloud.h"
+#include "../figures/line.h"
+#include "../figures/segment.h"
+#include "../figures/circle.h"
+
+namespace figfit
+{
+
+/**
+ * @struct SegmentRecord figure_log.h
+ *
+ * @brief Plain record of a segment as stored in a log
+ */
+struct SegmentRecord
+{
+  double start_x;   /**< @brief Abscissa of the start point */
+  double start_y;   /**< @brief Ordinate of the start point */
+  double end_x;     /**< @brief Abscissa of the end point */
+  double end_y;     /**< @brief Ordinate of the end point */
+
+  /**
+   * @brief Get segment of the record
+   */
+  Segment segment() const {
+    return Segment(Point(start_x, start_y), Point(end_x, end_y));
+  }
+};
+
+/**
+ * @struct CircleRecord figure_log.h
+ *
+ * @brief Plain record of a circle as stored in a log
+ */
+struct CircleRecord
+{
+  double center_x;  /**< @brief Abscissa of the center */
+  double center_y;  /**< @brief Ordinate of the center */
+  double radius;    /**< @brief Radius */
+
+  /**
+   * @brief Get circle of the record
+   */
+  Circle circle() const {
+    return Circle(Point(center_x, center_y), radius);
+  }
+};
+
+/**
+ * @struct LineRecord figure_log.h
+ *
+ * @brief Plain record of a line as stored in a log
+ */
+struct LineRecord
+{
+  double A;   /**< @brief Normalized parameter A */
+  double B;   /**< @brief Normalized parameter B */
+  double C;   /**< @brief Normalized parameter C */
+
+  /**
+   * @brief Get line of the record
+   */
+  Line line() const {
+    return Line(A, B, C);
+  }
+};
+
+/**
+ * @class RecordView figure_log.h
+ *
+ * @brief Non-owning view of an array of records
+ */
+template <typename T>
+class RecordView
+{
+public:
+
+  /**
+   * @brief Construction from array (default)
+   */
+  RecordView(const T* data = nullptr, size_t size = 0) :
+    data_(data), size_(size)
+  {}
+
+  /**
+   * @brief Get number of records
+   */
+  size_t size() const {
+    return size_;
+  }
+
+  /**
+   * @brief Check if the view is empty
+   */
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief Get i-th record
+   */
+  const T& operator[](size_t i) const {
+    return data_[i];
+  }
+
+  /**
+   * @brief Get pointer to the first record
+   */
+  const T* begin() const {
+    return data_;
+  }
+
+  /**
+   * @brief Get pointer past the last record
+   */
+  const T* end() const {
+    return data_ + size_;
+  }
+
+private:
+
+  const T* data_;   /**< @brief Array of records */
+  size_t size_;     /**< @brief Number of records */
+};
+
+/**
+ * @struct LogFormat figure_log.h
+ *
+ * @brief Layout of the binary log of scans and figures (version 1)
+ *
+ * The file starts with a Header and continues with frames. A frame is a
+ * sequence of blocks, each of which is a BlockHeader followed by the payload:
+ * the x coordinates and then the y coordinates of points, or an array of
+ * records of one figure type. The file ends with the index, an array of
+ * IndexEntry structures, one per frame, pointed to by the header. All of the
+ * fields are in the native byte order and all of the sizes are multiples of
+ * eight bytes, so the payloads are properly aligned in a mapped file. Blocks
+ * of unknown types are skipped by the reader, which lets later versions add
+ * new figure types.
+ */
+struct LogFormat
+{
+  static const uint32_t magic = 0x474c4646;   /**< @brief "FFLG" */
+  static const uint32_t version = 1;          /**< @brief Format version */
+
+  /**
+   * @brief Types of blocks
+   */
+  enum BlockType : uint32_t
+  {
+    Points = 1,
+    Segments = 2,
+    Circles = 3,
+    Lines = 4
+  };
+
+  /**
+   * @struct Header
+   *
+   * @brief Header of the file
+   */
+  struct Header
+  {
+    uint32_t magic;         /**< @brief LogFormat::magic */
+    uint32_t version;       /**< @brief Version of the format */
+    uint64_t index_offset;  /**< @brief Offset of the index, 0 if not closed */
+    uint64_t frames;        /**< @brief Number of entries of the index */
+  };
+
+  /**
+   * @struct BlockHeader
+   *
+   * @brief Header of a block of a frame
+   */
+  struct BlockHeader
+  {
+    uint32_t type;    /**< @brief Type of the block */
+    uint32_t unused;  /**< @brief Padding */
+    uint64_t count;   /**< @brief Number of points or records */
+    uint64_t bytes;   /**< @brief Size of the payload */
+  };
+
+  /**
+   * @struct IndexEntry
+   *
+   * @brief Entry of the index
+   */
+  struct IndexEntry
+  {
+    uint64_t sequence;  /**< @brief Sequence number of the frame */
+    double stamp;       /**< @brief Time stamp of the frame */
+    uint64_t offset;    /**< @brief Offset of the first block of the frame */
+    uint64_t bytes;     /**< @brief Size of all blocks of the frame */
+  };
+};
+
+/**
+ * @class LogWriter figure_log.h
+ *
+ * @brief Writer of the binary log of scans and figures
+ *
+ * Appends frames of points and fitted figures to a file in the LogFormat.
+ * The index is written by close(), which is also called on destruction. A
+ * file that was not closed has no index and cannot be read.
+ */
+class LogWriter
+{
+public:
+
+  /**
+   * @brief Construction with creation of a file
+   *
+   * @param path is the path of the file, an existing file is overwritten
+   *
+   * @throw std::runtime_error if the file cannot be created
+   */
+  explicit LogWriter(const std::string& path) :
+    file_(fopen(path.c_str(), "wb")),
+    offset_(0)
+  {
+    if (!file_)
+      throw std::runtime_error("Could not create log file " + path);
+
+    LogFormat::Header header = {LogFormat::magic, LogFormat::version, 0, 0};
+    put(&header, sizeof(header));
+  }
+
+  LogWriter(const LogWriter& rhs) = delete;
+  LogWriter& operator=(const LogWriter& rhs) = delete;
+
+  /**
+   * @brief Destruction (closes the file)
+   */
+  ~LogWriter() {
+    try {
+      close();
+    }
+    catch (...) {}
+  }
+
+  /**
+   * @brief Write a frame
+   *
+   * The arrays of figures may be any vectors of figures, e.g. SegmentArray or
+   * pmr::SegmentArray.
+   *
+   * @param sequence is the sequence number of the frame
+   * @param stamp is the time stamp of the frame
+   * @param points is the view of points of the frame
+   * @param segments are the segments fitted in the frame
+   * @param circles are the circles fitted in the frame
+   * @param lines are the lines fitted in the frame
+   *
+   * @throw std::runtime_error if writing fails or the log is closed
+   */
+  template <typename SegmentAllocator = std::allocator<Segment>,
+            typename CircleAllocator = std::allocator<Circle>,
+            typename LineAllocator = std::allocator<Line>>
+  void write(uint64_t sequence, double stamp, const PointCloudView& points,
+             const std::vector<Segment, SegmentAllocator>& segments =
+                 std::vector<Segment, SegmentAllocator>(),
+             const std::vector<Circle, CircleAllocator>& circles =
+                 std::vector<Circle, CircleAllocator>(),
+             const std::vector<Line, LineAllocator>& lines =
+                 std::vector<Line, LineAllocator>()) {
+    if (!file_)
+      throw std::runtime_error("Could not write to closed log");
+
+    LogFormat::IndexEntry entry = {sequence, stamp, offset_, 0};
+
+    putBlock(LogFormat::Points, points.size(),
+             2 * points.size() * sizeof(double));
+    put(points.xData(), points.size() * sizeof(double));
+    put(points.yData(), points.size() * sizeof(double));
+
+    if (!segments.empty()) {
+      putBlock(LogFormat::Segments, segments.size(),
+               segments.size() * sizeof(SegmentRecord));
+      for (const Segment& s : segments) {
+        SegmentRecord r = {s.startPoint().x, s.startPoint().y,
+                           s.endPoint().x, s.endPoint().y};
+        put(&r, sizeof(r));
+      }
+    }
+
+    if (!circles.empty()) {
+      putBlock(LogFormat::Circles, circles.size(),
+               circles.size() * sizeof(CircleRecord));
+      for (const Circle& c : circles) {
+        CircleRecord r = {c.center().x, c.center().y, c.radius()};
+        put(&r, sizeof(r));
+      }
+    }
+
+    if (!lines.empty()) {
+      putBlock(LogFormat::Lines, lines.size(),
+               lines.size() * sizeof(LineRecord));
+      for (const Line& l : lines) {
+        LineRecord r = {l.A(), l.B(), l.C()};
+        put(&r, sizeof(r));
+      }
+    }
+
+    entry.bytes = offset_ - entry.offset;
+    index_.push_back(entry);
+  }
+
+  /**
+   * @brief Write the index and close the file
+   *
+   * @throw std::runtime_error if writing fails
+   */
+  void close() {
+    if (!file_)
+      return;
+
+    LogFormat::Header header = {LogFormat::magic, LogFormat::version,
+                                offset_, index_.size()};
+    put(index_.data(), index_.size() * sizeof(LogFormat::IndexEntry));
+
+    bool failed = fseek(file_, 0, SEEK_SET) != 0 ||
+                  fwrite(&header, sizeof(header), 1, file_) != 1;
+    failed = (fclose(file_) != 0) || failed;
+    file_ = nullptr;
+
+    if (failed)
+      throw std::runtime_error("Error while closing log file");
+  }
+
+  /**
+   * @brief Get number of written frames
+   */
+  size_t frames() const {
+    return index_.size();
+  }
+
+private:
+
+  void putBlock(uint32_t type, uint64_t count, uint64_t bytes) {
+    LogFormat::BlockHeader block = {type, 0, count, bytes};
+    put(&block, sizeof(block));
+  }
+
+  void put(const void* data, size_t bytes) {
+    if (bytes != 0 && fwrite(data, bytes, 1, file_) != 1)
+      throw std::runtime_error("Error while writing log file");
+    offset_ += bytes;
+  }
+
+  FILE* file_;                                  /**< @brief Written file */
+  uint64_t offset_;                             /**< @brief Current offset */
+  std::vector<LogFormat::IndexEntry> index_;    /**< @brief Written frames */
+};
+
+/**
+ * @struct LogFrame figure_log.h
+ *
+ * @brief Frame of a mapped log
+ *
+ * All of the views point directly into the mapped file, hence they are valid
+ * as long as the LogReader exists.
+ */
+struct LogFrame
+{
+  uint64_t sequence;                    /**< @brief Sequence number */
+  double stamp;                         /**< @brief Time stamp */
+  PointCloudView points;                /**< @brief Points */
+  RecordView<SegmentRecord> segments;   /**< @brief Fitted segments */
+  RecordView<CircleRecord> circles;     /**< @brief Fitted circles */
+  RecordView<LineRecord> lines;         /**< @brief Fitted lines */
+};
+
+/**
+ * @class LogReader figure_log.h
+ *
+ * @brief Memory-mapped reader of the binary log of scans and figures
+ *
+ * Maps the whole file read-only and finds frames through the index. Points
+ * and figure records are not copied nor deserialized; the frames only hold
+ * views into the mapping, so reading a log is bounded by the disk bandwidth.
+ */
+class LogReader
+{
+public:
+
+  /**
+   * @brief Construction with mapping of a file
+   *
+   * @param path is the path of the file
+   *
+   * @throw std::runtime_error if the file cannot be mapped or is not a valid
+   * log
+   */
+  explicit LogReader(const std::string& path) :
+    file_(path),
+    data_(file_.data()),
+    size_(file_.size()),
+    index_(nullptr),
+    frames_(0)
+  {
+    LogFormat::Header header;
+    bool valid = size_ >= sizeof(header);
+    if (valid) {
+      memcpy(&header, data_, sizeof(header));
+      valid = header.magic == LogFormat::magic &&
+              header.version == LogFormat::version &&
+              header.index_offset >= sizeof(header) &&
+              header.index_offset <= size_ &&
+              header.frames <= (size_ - header.index_offset) /
+                               sizeof(LogFormat::IndexEntry);
+    }
+
+    if (!valid)
+      throw std::runtime_error("Invalid or unclosed log file " + path);
+
+    index_ = reinterpret_cast<const LogFormat::IndexEntry*>(
+               data_ + header.index_offset);
+    frames_ = header.frames;
+  }
+
+  LogReader(const LogReader& rhs) = delete;
+  LogReader& operator=(const LogReader& rhs) = delete;
+
+  /**
+   * @brief Get number of frames
+   */
+  size_t size() const {
+    return frames_;
+  }
+
+  /**
+   * @brief Get i-th frame
+   *
+   * @throw std::out_of_range if there is no such frame
+   * @throw std::runtime_error if the frame is corrupted
+   */
+  LogFrame frame(size_t i) const {
+    if (i >= frames_)
+      throw std::out_of_range("Frame exceeds the log");
+
+    const LogFormat::IndexEntry& entry = index_[i];
+    if (entry.offset > size_ || entry.bytes > size_ - entry.offset)
+      throw std::runtime_error("Corrupted log frame");
+
+    LogFrame frame;
+    frame.sequence = entry.sequence;
+    frame.stamp = entry.stamp;
+
+    const char* block = data_ + entry.offset;
+    const char* end = block + entry.bytes;
+    while (block < end) {
+      LogFormat::BlockHeader header;
+      if (size_t(end - block) < sizeof(header))
+        throw std::runtime_error("Corrupted log frame");
+
+      memcpy(&header, block, sizeof(header));
+      block += sizeof(header);
+      if (header.bytes > size_t(end - block))
+        throw std::runtime_error("Corrupted log frame");
+
+      switch (header.type) {
+      case LogFormat::Points: {
+        // The count is compared by division first, a huge one would wrap
+        if (header.count > header.bytes / (2 * sizeof(double)) ||
+            header.count * 2 * sizeof(double) != header.bytes)
+          throw std::runtime_error("Corrupted log frame");
+
+        const double* x = reinterpret_cast<const double*>(block);
+        frame.points = PointCloudView(x, x + header.count, header.count);
+        break;
+      }
+      case LogFormat::Segments:
+        frame.segments = records<SegmentRecord>(block, header);
+        break;
+      case LogFormat::Circles:
+        frame.circles = records<CircleRecord>(block, header);
+        break;
+      case LogFormat::Lines:
+        frame.lines = records<LineRecord>(block, header);
+        break;
+      }
+
+      block += header.bytes;
+    }
+
+    return frame;
+  }
+
+private:
+
+  template <typename T>
+  static RecordView<T> records(const char* block,
+                               const LogFormat::BlockHeader& header) {
+    if (header.count > header.bytes / sizeof(T) ||
+        header.count * sizeof(T) != header.bytes)
+      throw std::runtime_error("Corrupted log frame");
+
+    return RecordView<T>(reinterpret_cast<const T*>(block), header.count);
+  }
+
+  MappedFile file_;                       /**< @brief Mapping of the file */
+  const char* data_;                      /**< @brief Mapped file */
+  size_t size_;                           /**< @brief Size of the file */
+  const LogFormat::IndexEntry* index_;    /**< @brief Mapped index */
+  size_t frames_;                         /**< @brief Number of frames */
+};
+
+} // end namespace figfit
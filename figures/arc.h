@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory_resource>
+#include <vector>
+
 #include "../figures/circle.h"
 
 namespace figfit
@@ -75,6 +78,25 @@ public:
     end_ = atan2(stop.y - center_.y, stop.x - center_.x);
   }
 
+  /**
+   * @brief Create arc from three points without throwing
+   *
+   * @param start is a start-point of the arc
+   * @param stop is an end-point of the arc
+   * @param aux is an auxiliary point for construction of supporting circle
+   *
+   * @return arc or FitStatus::Collinear if the points lay on the same line
+   *
+   * @sa Arc(const Point&, const Point&, const Point&)
+   */
+  static Result<Arc> tryCreate(const Point& start, const Point& stop,
+                               const Point& aux) {
+    if (findDenominator(start, stop, aux) == 0.0)
+      return FitStatus::Collinear;
+
+    return Arc(start, stop, aux);
+  }
+
   //
   // Inherited methods
   //
@@ -86,6 +108,20 @@ public:
     return Circle::normalTo(p);
   }
 
+  /**
+   * @brief Compute normal vector from this arc to a given point without
+   * throwing
+   *
+   * @sa normalTo()
+   */
+  virtual Result<Vec> tryNormalTo(const Point &p) const override {
+    Result<Point> projection = Circle::tryFindProjectionOf(p);
+    if (!projection)
+      return projection.status();
+
+    return (p - *projection).tryNormalized();
+  }
+
   /**
    * @brief Compute squared distance from this circle to a given point
    */
@@ -138,6 +174,19 @@ public:
     return p;
   }
 
+  /**
+   * @brief Find projection of a given point onto this arc without throwing
+   *
+   * @return projection or FitStatus::Degenerate if a point coincides with the
+   * circle center, from which all of the points of the arc are equidistant
+   */
+  virtual Result<Point> tryFindProjectionOf(const Point &p) const override {
+    if (p == center_)
+      return FitStatus::Degenerate;
+
+    return findProjectionOf(p);
+  }
+
   // Hide these methods inherited from circle:
   bool isEncircling(const Point& p) const = delete;
   bool isEncircling(const Circle& c) const = delete;
@@ -186,6 +235,23 @@ public:
     return 1;
   }
 
+  /**
+   * @brief Get parametric representation of a point on this arc without
+   * throwing
+   *
+   * @param p is a given point
+   *
+   * @return parameter theta or FitStatus::Degenerate if the length of this arc
+   * is zero or p is located at the center of arc circle
+   *
+   * @sa parametricRepresentation()
+   */
+  Result<double> tryParametricRepresentation(const Point& p) const {
+    if (length() == 0.0 || p == center_)
+      return FitStatus::Degenerate;
+
+    return parametricRepresentation(p);
+  }
 
 //  double parametricRepresentation(double phi) const {
 //    double midway = (a >= 0.0 ? a : a + M_PI) / 2.0;
@@ -303,4 +369,18 @@ private:
   double end_;     /**< @brief End-point angle */
 };
 
+/**
+ * @brief Array of arcs
+ */
+typedef std::vector<Arc> ArcArray;
+
+namespace pmr {
+
+/**
+ * @brief Array of arcs taking memory from a std::pmr::memory_resource
+ */
+typedef std::pmr::vector<Arc> ArcArray;
+
+} // end namespace pmr
+
 } // end namespace figfit
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory_resource>
+#include <vector>
+
 #include "figure.h"
 #include "point.h"
 
@@ -55,9 +58,7 @@ public:
    * @throw std::logic_error if the points are located on the same line
    */
   Circle(const Point& p1, const Point& p2, const Point& p3) {
-    double denominator = 2.0 * (p1.x * (p2.y - p3.y) -
-                                p1.y * (p2.x - p3.x) +
-                                p2.x * p3.y - p3.x * p2.y);
+    double denominator = findDenominator(p1, p2, p3);
 
     if (denominator == 0.0)
       throw std::logic_error("Cannot create circle from three points lying on "
@@ -75,6 +76,26 @@ public:
     radius_ = (p1 - center_).length();
   }
 
+  /**
+   * @brief Create circle from three points without throwing
+   *
+   * @param p1 is the first point
+   * @param p2 is the second point
+   * @param p3 is the third point
+   *
+   * @return circle or FitStatus::Collinear if the points are located on the
+   * same line
+   *
+   * @sa Circle(const Point&, const Point&, const Point&)
+   */
+  static Result<Circle> tryCreate(const Point& p1, const Point& p2,
+                                  const Point& p3) {
+    if (findDenominator(p1, p2, p3) == 0.0)
+      return FitStatus::Collinear;
+
+    return Circle(p1, p2, p3);
+  }
+
   //
   // Inherited methods
   //
@@ -115,6 +136,20 @@ public:
     return radius_ * (p - center_).normalized() + center_;
   }
 
+  /**
+   * @brief Find projection of a given point onto this circle without throwing
+   *
+   * @return projection or FitStatus::Degenerate if a point coincides with the
+   * circle center
+   */
+  virtual Result<Point> tryFindProjectionOf(const Point& p) const override {
+    Result<Vec> direction = (p - center_).tryNormalized();
+    if (!direction)
+      return direction.status();
+
+    return Point(radius_ * *direction + center_);
+  }
+
   //
   // Circle specific methods
   //
@@ -189,8 +224,34 @@ public:
 
 protected:
 
+  /**
+   * @brief Find denominator of the center of circle through three points
+   *
+   * @return four times the signed area of the triangle, zero for collinear
+   * points
+   */
+  static double findDenominator(const Point& p1, const Point& p2,
+                                const Point& p3) {
+    return 2.0 * (p1.x * (p2.y - p3.y) - p1.y * (p2.x - p3.x) +
+                  p2.x * p3.y - p3.x * p2.y);
+  }
+
   Point center_;    /**< @brief Central point of the circle */
   double radius_;   /**< @brief Radius of the circle */
 };
 
+/**
+ * @brief Array of circles
+ */
+typedef std::vector<Circle> CircleArray;
+
+namespace pmr {
+
+/**
+ * @brief Array of circles taking memory from a std::pmr::memory_resource
+ */
+typedef std::pmr::vector<Circle> CircleArray;
+
+} // end namespace pmr
+
 } // end namespace figfit
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <limits>
+
+#include "figure.h"
+#include "point.h"
+
+namespace figfit {
+
+/**
+ * @class Ellipse ellipse.h
+ *
+ * @brief The Ellipse class
+ *
+ * The ellipse is a Figure represented by a central point, two semi-axes and
+ * the orientation of the major axis. The semi-major axis is always greater
+ * than or equal to the semi-minor axis and both are greater than or equal to
+ * zero. An ellipse is represented by its circumference and not by its
+ * interior.
+ */
+class Ellipse : public Figure
+{
+public:
+
+  //
+  // Constructors
+  //
+
+  virtual ~Ellipse() = default;
+
+  Ellipse(const Ellipse& rhs) = default;
+  Ellipse& operator=(const Ellipse& rhs) = default;
+
+  Ellipse(Ellipse&& rhs) = default;
+  Ellipse& operator=(Ellipse&& rhs) = default;
+
+  /**
+   * @brief Construction from point, semi-axes and angle (default)
+   *
+   * If the second semi-axis is greater than the first one, the semi-axes are
+   * swapped and the angle is rotated by pi/2. The angle is brought to range
+   * (-pi/2, pi/2]. Note that the default ellipse is a unit circle at (0, 0).
+   *
+   * @param center is the central point of the ellipse
+   * @param a is the semi-axis along the angle (absolute value is taken)
+   * @param b is the semi-axis perpendicular to the angle (absolute value is
+   * taken)
+   * @param angle is the orientation of semi-axis a in radians
+   */
+  Ellipse(const Point& center = Point(), double a = 1.0, double b = 1.0,
+          double angle = 0.0) :
+    center_(center),
+    a_(std::abs(a)),
+    b_(std::abs(b)),
+    angle_(angle)
+  {
+    if (b_ > a_) {
+      std::swap(a_, b_);
+      angle_ += M_PI / 2.0;
+    }
+
+    angle_ = atan(tan(angle_));
+    if (angle_ == -M_PI / 2.0)
+      angle_ = M_PI / 2.0;
+
+    cos_ = cos(angle_);
+    sin_ = sin(angle_);
+  }
+
+  //
+  // Inherited methods
+  //
+
+  /**
+   * @brief Compute normal vector from this ellipse to a given point
+   *
+   * @throw std::logic_error if a point lays on the ellipse
+   */
+  virtual Vec normalTo(const Point& p) const override {
+    return (p - findProjectionOf(p)).normalized();
+  }
+
+  /**
+   * @brief Compute approximated squared distance from this ellipse to a given
+   * point
+   *
+   * Uses the first-order approximation d = h / |grad h| of the function
+   * h = sqrt(u^2 / a^2 + v^2 / b^2) - 1, where (u, v) are the coordinates of
+   * the point in the frame of the ellipse. The approximation is exact for
+   * circles and for points on the ellipse and its error grows with the
+   * eccentricity and the distance. Use distanceTo() for the exact value.
+   */
+  virtual double distanceSquaredTo(const Point& p) const override {
+    Vec local = toLocal(p);
+
+    double u_a = local.x / a_;
+    double v_b = local.y / b_;
+    double g_squared = u_a * u_a + v_b * v_b;
+
+    if (g_squared == 0.0)
+      return b_ * b_;
+
+    double grad_squared = u_a * u_a / (a_ * a_) + v_b * v_b / (b_ * b_);
+    double g = sqrt(g_squared);
+
+    return (g - 1.0) * (g - 1.0) * g_squared / grad_squared;
+  }
+
+  /**
+   * @brief Compute exact distance from this ellipse to a given point
+   *
+   * Computed as the distance to findProjectionOf(), hence it is considerably
+   * more expensive than distanceSquaredTo().
+   */
+  virtual double distanceTo(const Point& p) const override {
+    return (p - findProjectionOf(p)).length();
+  }
+
+  /**
+   * @brief Find projection of a given point onto this ellipse
+   *
+   * Finds the exact nearest point with the robust bisection method of D.
+   * Eberly ("Distance from a Point to an Ellipse, an Ellipsoid, or a
+   * Hyperellipsoid"). The problem is reduced to the first quadrant of the
+   * ellipse frame, where the root of a monotonic function is bracketed.
+   */
+  virtual Point findProjectionOf(const Point& p) const override {
+    Vec local = toLocal(p);
+
+    double y0 = std::abs(local.x);
+    double y1 = std::abs(local.y);
+    double x0, x1;
+
+    if (b_ == 0.0) {
+      x0 = std::min(y0, a_);
+      x1 = 0.0;
+    }
+    else if (y1 > 0.0) {
+      if (y0 > 0.0) {
+        double z0 = y0 / a_;
+        double z1 = y1 / b_;
+        double g = z0 * z0 + z1 * z1 - 1.0;
+
+        if (g != 0.0) {
+          double r0 = (a_ / b_) * (a_ / b_);
+          double s = findRoot(r0, z0, z1, g);
+          x0 = r0 * y0 / (s + r0);
+          x1 = y1 / (s + 1.0);
+        }
+        else {
+          x0 = y0;
+          x1 = y1;
+        }
+      }
+      else {
+        x0 = 0.0;
+        x1 = b_;
+      }
+    }
+    else {
+      double numerator = a_ * y0;
+      double denominator = a_ * a_ - b_ * b_;
+
+      if (numerator < denominator) {
+        double ratio = numerator / denominator;
+        x0 = a_ * ratio;
+        x1 = b_ * sqrt(1.0 - ratio * ratio);
+      }
+      else {
+        x0 = a_;
+        x1 = 0.0;
+      }
+    }
+
+    return toGlobal(Vec(std::copysign(x0, local.x),
+                        std::copysign(x1, local.y)));
+  }
+
+  //
+  // Ellipse specific methods
+  //
+
+  /**
+   * @brief Check if a given point is inside this ellipse
+   *
+   * Point lying on the circumference of the ellipse is assumed to be
+   * encircled by it.
+   *
+   * @param p is a given point
+   *
+   * @return true if p is inside this ellipse
+   */
+  bool isEncircling(const Point& p) const {
+    Vec local = toLocal(p);
+    return pow(local.x * b_, 2.0) + pow(local.y * a_, 2.0) <=
+           pow(a_ * b_, 2.0);
+  }
+
+  /**
+   * @brief Get center
+   *
+   * @return central point of this ellipse
+   */
+  Point center() const {
+    return center_;
+  }
+
+  /**
+   * @brief Get semi-major axis
+   *
+   * @return semi-major axis of this ellipse
+   */
+  double semiMajorAxis() const {
+    return a_;
+  }
+
+  /**
+   * @brief Get semi-minor axis
+   *
+   * @return semi-minor axis of this ellipse
+   */
+  double semiMinorAxis() const {
+    return b_;
+  }
+
+  /**
+   * @brief Get angle
+   *
+   * @return orientation of the major axis in radians, in range (-pi/2, pi/2]
+   */
+  double angle() const {
+    return angle_;
+  }
+
+  /**
+   * @brief Create a point on this ellipse based on parametric angle theta
+   *
+   * The point is (a cos(theta), b sin(theta)) in the frame of the ellipse.
+   * Note that theta is not the direction of the point from the center.
+   *
+   * @param theta is a parametric angle in radians
+   *
+   * @return point created on the ellipse
+   */
+  Point createPointFromAngle(double theta) const {
+    return toGlobal(Vec(a_ * cos(theta), b_ * sin(theta)));
+  }
+
+  //
+  // Ostream operator
+  //
+
+  friend std::ostream& operator<<(std::ostream& out, const Ellipse& e) {
+    out << "[" << e.center_ << ", " << e.a_ << ", " << e.b_ << ", "
+        << e.angle_ << "]";
+    return out;
+  }
+
+protected:
+
+  /**
+   * @brief Transform a given point into the frame of this ellipse
+   */
+  Vec toLocal(const Point& p) const {
+    Vec v = p - center_;
+    return Vec(cos_ * v.x + sin_ * v.y, -sin_ * v.x + cos_ * v.y);
+  }
+
+  /**
+   * @brief Transform a given vector from the frame of this ellipse
+   */
+  Point toGlobal(const Vec& v) const {
+    return center_ + Vec(cos_ * v.x - sin_ * v.y, sin_ * v.x + cos_ * v.y);
+  }
+
+  /**
+   * @brief Find root of the distance function by bisection
+   *
+   * @param r0 is the squared ratio of semi-axes
+   * @param z0 is the first coordinate scaled by the semi-major axis
+   * @param z1 is the second coordinate scaled by the semi-minor axis
+   * @param g is the value of the function at zero
+   *
+   * @return root of the function
+   */
+  static double findRoot(double r0, double z0, double z1, double g) {
+    double n0 = r0 * z0;
+    double s0 = z1 - 1.0;
+    double s1 = (g < 0.0) ? 0.0 : sqrt(n0 * n0 + z1 * z1) - 1.0;
+    double s = 0.0;
+
+    const int max_iterations = std::numeric_limits<double>::digits -
+                               std::numeric_limits<double>::min_exponent;
+
+    for (int i = 0; i < max_iterations; ++i) {
+      s = (s0 + s1) / 2.0;
+      if (s == s0 || s == s1)
+        break;
+
+      double ratio0 = n0 / (s + r0);
+      double ratio1 = z1 / (s + 1.0);
+      g = ratio0 * ratio0 + ratio1 * ratio1 - 1.0;
+
+      if (g > 0.0)
+        s0 = s;
+      else if (g < 0.0)
+        s1 = s;
+      else
+        break;
+    }
+
+    return s;
+  }
+
+  Point center_;    /**< @brief Central point of the ellipse */
+  double a_;        /**< @brief Semi-major axis of the ellipse */
+  double b_;        /**< @brief Semi-minor axis of the ellipse */
+  double angle_;    /**< @brief Orientation of the major axis */
+  double cos_;      /**< @brief Cosine of the orientation */
+  double sin_;      /**< @brief Sine of the orientation */
+};
+
+} // end namespace figfit
@@ -41,6 +41,18 @@ public:
    */
   virtual Vec normalTo(const Point& p) const = 0;
 
+  /**
+   * @brief Compute normal vector without throwing
+   *
+   * @param p is a given point
+   *
+   * @return normal vector or FitStatus::Degenerate if a given point lays on
+   * the figure
+   *
+   * @sa normalTo()
+   */
+  virtual Result<Vec> tryNormalTo(const Point& p) const;
+
   /**
    * @brief Compute squared distance to point
    *
@@ -78,6 +90,18 @@ public:
    * @return point on the figure that is nearest to the given point
    */
   virtual Point findProjectionOf(const Point& p) const = 0;
+
+  /**
+   * @brief Find projection of given point onto the figure without throwing
+   *
+   * @param p is a given point
+   *
+   * @return point on the figure that is nearest to the given point or
+   * FitStatus::Degenerate if it is not unique
+   *
+   * @sa findProjectionOf()
+   */
+  virtual Result<Point> tryFindProjectionOf(const Point& p) const;
 };
 
 } // end namespace figfit
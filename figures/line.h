@@ -2,6 +2,8 @@
 
 #include <stdexcept>
 #include <limits>
+#include <memory_resource>
+#include <vector>
 
 #include "figure.h"
 #include "point.h"
@@ -89,6 +91,41 @@ public:
     normalizeCoefficients();
   }
 
+  /**
+   * @brief Create line from parameters without throwing
+   *
+   * @param A is A
+   * @param B is B
+   * @param C is C
+   *
+   * @return line or FitStatus::Degenerate if both A = 0 and B = 0
+   *
+   * @sa Line(double, double, double)
+   */
+  static Result<Line> tryCreate(double A, double B, double C) {
+    if (A == 0.0 && B == 0.0)
+      return FitStatus::Degenerate;
+
+    return Line(A, B, C);
+  }
+
+  /**
+   * @brief Create line from two points without throwing
+   *
+   * @param p1 is first point
+   * @param p2 is second point
+   *
+   * @return line or FitStatus::Degenerate if p1 = p2
+   *
+   * @sa Line(const Point&, const Point&)
+   */
+  static Result<Line> tryCreate(const Point& p1, const Point& p2) {
+    if (p1 == p2)
+      return FitStatus::Degenerate;
+
+    return Line(p1, p2);
+  }
+
   //
   // Inherited methods
   //
@@ -147,6 +184,22 @@ public:
                  (C_ * l.A_ - A_ * l.C_) / denominator);
   }
 
+  /**
+   * @brief Find intersection with given line without throwing
+   *
+   * @param l is a given line
+   *
+   * @return point of intersection or FitStatus::Parallel if lines are parallel
+   *
+   * @sa findIntersectionWith()
+   */
+  Result<Point> tryFindIntersectionWith(const Line& l) const {
+    if (isParallelTo(l))
+      return FitStatus::Parallel;
+
+    return findIntersectionWith(l);
+  }
+
   /**
    * @brief Check if given line is parallel to this
    *
@@ -203,6 +256,40 @@ public:
     return Point(-(B_ * y_coord + C_) / A_, y_coord);
   }
 
+  /**
+   * @brief Create point on the line given x coordinate without throwing
+   *
+   * @param x_coord is the coordinate on abscissa
+   *
+   * @return point on the line or FitStatus::NoSolution if the line is
+   * vertical
+   *
+   * @sa createPointFromX()
+   */
+  Result<Point> tryCreatePointFromX(double x_coord) const {
+    if (B_ == 0.0)
+      return FitStatus::NoSolution;
+
+    return createPointFromX(x_coord);
+  }
+
+  /**
+   * @brief Create point on the line given y coordinate without throwing
+   *
+   * @param y_coord is the coordinate on ordinate
+   *
+   * @return point on the line or FitStatus::NoSolution if the line is
+   * horizontal
+   *
+   * @sa createPointFromY()
+   */
+  Result<Point> tryCreatePointFromY(double y_coord) const {
+    if (A_ == 0.0)
+      return FitStatus::NoSolution;
+
+    return createPointFromY(y_coord);
+  }
+
   /**
    * @brief Get A
    *
@@ -267,4 +354,18 @@ private:
   }
 };
 
+/**
+ * @brief Array of lines
+ */
+typedef std::vector<Line> LineArray;
+
+namespace pmr {
+
+/**
+ * @brief Array of lines taking memory from a std::pmr::memory_resource
+ */
+typedef std::pmr::vector<Line> LineArray;
+
+} // end namespace pmr
+
 } // end namespace figfit
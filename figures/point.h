@@ -81,4 +81,20 @@ public:
   }
 };
 
+//
+// Methods of Figure requiring complete Point
+//
+
+inline Result<Vec> Figure::tryNormalTo(const Point& p) const {
+  Result<Point> projection = tryFindProjectionOf(p);
+  if (!projection)
+    return projection.status();
+
+  return (p - *projection).tryNormalized();
+}
+
+inline Result<Point> Figure::tryFindProjectionOf(const Point& p) const {
+  return findProjectionOf(p);
+}
+
 } // end namespace figfit
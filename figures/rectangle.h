@@ -0,0 +1,237 @@
+#pragma once
+
+#include "figure.h"
+#include "point.h"
+
+namespace figfit {
+
+/**
+ * @class Rectangle rectangle.h
+ *
+ * @brief The Rectangle class
+ *
+ * The rectangle is a Figure represented by a central point, a length, a width
+ * and an orientation. The length is measured along the orientation and the
+ * width perpendicular to it. Both are greater than or equal to zero. A
+ * rectangle is represented by its boundary and not by its interior.
+ */
+class Rectangle : public Figure
+{
+public:
+
+  //
+  // Constructors
+  //
+
+  virtual ~Rectangle() = default;
+
+  Rectangle(const Rectangle& rhs) = default;
+  Rectangle& operator=(const Rectangle& rhs) = default;
+
+  Rectangle(Rectangle&& rhs) = default;
+  Rectangle& operator=(Rectangle&& rhs) = default;
+
+  /**
+   * @brief Construction from point, sizes and angle (default)
+   *
+   * The angle is brought to range (-pi/2, pi/2]. Note that the default
+   * rectangle is a unit square at (0, 0).
+   *
+   * @param center is the central point of the rectangle
+   * @param length is the size along the angle (absolute value is taken)
+   * @param width is the size perpendicular to the angle (absolute value is
+   * taken)
+   * @param angle is the orientation of the rectangle in radians
+   */
+  Rectangle(const Point& center = Point(), double length = 1.0,
+            double width = 1.0, double angle = 0.0) :
+    center_(center),
+    half_length_(std::abs(length) / 2.0),
+    half_width_(std::abs(width) / 2.0),
+    angle_(atan(tan(angle)))
+  {
+    if (angle_ == -M_PI / 2.0)
+      angle_ = M_PI / 2.0;
+
+    cos_ = cos(angle_);
+    sin_ = sin(angle_);
+  }
+
+  //
+  // Inherited methods
+  //
+
+  /**
+   * @brief Compute normal vector from this rectangle to a given point
+   *
+   * @throw std::logic_error if a point lays on the rectangle
+   */
+  virtual Vec normalTo(const Point& p) const override {
+    return (p - findProjectionOf(p)).normalized();
+  }
+
+  /**
+   * @brief Compute squared distance from this rectangle to a given point
+   *
+   * For points inside of the rectangle the distance to the nearest side is
+   * taken.
+   */
+  virtual double distanceSquaredTo(const Point& p) const override {
+    Vec local = toLocal(p);
+
+    double q_x = std::abs(local.x) - half_length_;
+    double q_y = std::abs(local.y) - half_width_;
+
+    if (q_x > 0.0 || q_y > 0.0) {
+      double o_x = std::max(q_x, 0.0);
+      double o_y = std::max(q_y, 0.0);
+      return o_x * o_x + o_y * o_y;
+    }
+
+    double d = std::min(-q_x, -q_y);
+    return d * d;
+  }
+
+  /**
+   * @brief Compute distance from this rectangle to a given point
+   */
+  virtual double distanceTo(const Point& p) const override {
+    return sqrt(distanceSquaredTo(p));
+  }
+
+  /**
+   * @brief Find projection of a given point onto this rectangle
+   *
+   * Points outside of the rectangle are clamped to it, points inside of it
+   * are moved to the nearest side.
+   */
+  virtual Point findProjectionOf(const Point& p) const override {
+    Vec local = toLocal(p);
+
+    double q_x = std::abs(local.x) - half_length_;
+    double q_y = std::abs(local.y) - half_width_;
+
+    if (q_x > 0.0 || q_y > 0.0) {
+      local.x = std::max(-half_length_, std::min(local.x, half_length_));
+      local.y = std::max(-half_width_, std::min(local.y, half_width_));
+    }
+    else if (q_x > q_y) {
+      local.x = std::copysign(half_length_, local.x);
+    }
+    else {
+      local.y = std::copysign(half_width_, local.y);
+    }
+
+    return toGlobal(local);
+  }
+
+  //
+  // Rectangle specific methods
+  //
+
+  /**
+   * @brief Check if a given point is inside this rectangle
+   *
+   * Point lying on the boundary of the rectangle is assumed to be enclosed by
+   * it.
+   *
+   * @param p is a given point
+   *
+   * @return true if p is inside this rectangle
+   */
+  bool isEnclosing(const Point& p) const {
+    Vec local = toLocal(p);
+    return std::abs(local.x) <= half_length_ &&
+           std::abs(local.y) <= half_width_;
+  }
+
+  /**
+   * @brief Get center
+   *
+   * @return central point of this rectangle
+   */
+  Point center() const {
+    return center_;
+  }
+
+  /**
+   * @brief Get length
+   *
+   * @return size of this rectangle along its orientation
+   */
+  double length() const {
+    return 2.0 * half_length_;
+  }
+
+  /**
+   * @brief Get width
+   *
+   * @return size of this rectangle perpendicular to its orientation
+   */
+  double width() const {
+    return 2.0 * half_width_;
+  }
+
+  /**
+   * @brief Get angle
+   *
+   * @return orientation of this rectangle in radians, in range (-pi/2, pi/2]
+   */
+  double angle() const {
+    return angle_;
+  }
+
+  /**
+   * @brief Get corner of this rectangle
+   *
+   * Corners are numbered in counter-clockwise direction, starting from the
+   * corner at (+length/2, +width/2) in the frame of the rectangle.
+   *
+   * @param i is the index of corner (taken modulo 4)
+   *
+   * @return i-th corner of this rectangle
+   */
+  Point corner(int i) const {
+    static const double signs_x[4] = {1.0, -1.0, -1.0, 1.0};
+    static const double signs_y[4] = {1.0, 1.0, -1.0, -1.0};
+
+    i = ((i % 4) + 4) % 4;
+    return toGlobal(Vec(signs_x[i] * half_length_, signs_y[i] * half_width_));
+  }
+
+  //
+  // Ostream operator
+  //
+
+  friend std::ostream& operator<<(std::ostream& out, const Rectangle& r) {
+    out << "[" << r.center_ << ", " << r.length() << ", " << r.width() << ", "
+        << r.angle_ << "]";
+    return out;
+  }
+
+protected:
+
+  /**
+   * @brief Transform a given point into the frame of this rectangle
+   */
+  Vec toLocal(const Point& p) const {
+    Vec v = p - center_;
+    return Vec(cos_ * v.x + sin_ * v.y, -sin_ * v.x + cos_ * v.y);
+  }
+
+  /**
+   * @brief Transform a given vector from the frame of this rectangle
+   */
+  Point toGlobal(const Vec& v) const {
+    return center_ + Vec(cos_ * v.x - sin_ * v.y, sin_ * v.x + cos_ * v.y);
+  }
+
+  Point center_;        /**< @brief Central point of the rectangle */
+  double half_length_;  /**< @brief Half of the size along the orientation */
+  double half_width_;   /**< @brief Half of the size across the orientation */
+  double angle_;        /**< @brief Orientation of the rectangle */
+  double cos_;          /**< @brief Cosine of the orientation */
+  double sin_;          /**< @brief Sine of the orientation */
+};
+
+} // end namespace figfit
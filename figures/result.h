@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdexcept>
+
+namespace figfit
+{
+
+/**
+ * @brief Outcome of a fit, construction or query
+ *
+ * Returned by the non-throwing variants of the methods of figures and
+ * fitters, which are prefixed with "try".
+ */
+enum class FitStatus
+{
+  Ok,               /**< @brief The operation succeeded */
+  TooFewPoints,     /**< @brief The point set is too small for the figure */
+  InvalidArgument,  /**< @brief A parameter is out of its range */
+  Degenerate,       /**< @brief Coinciding points or a vector of length zero */
+  Collinear,        /**< @brief The points lie on one line */
+  Parallel,         /**< @brief The lines are parallel */
+  NoSolution        /**< @brief The problem has no solution, e.g. the
+                         points do not determine the figure */
+};
+
+/**
+ * @brief Get description of a status
+ *
+ * @param status is the status
+ *
+ * @return static string describing the status
+ */
+inline const char* toString(FitStatus status) {
+  switch (status) {
+    case FitStatus::Ok:
+      return "success";
+    case FitStatus::TooFewPoints:
+      return "too few points in the set";
+    case FitStatus::InvalidArgument:
+      return "parameter out of range";
+    case FitStatus::Degenerate:
+      return "degenerate input";
+    case FitStatus::Collinear:
+      return "points lying on the same line";
+    case FitStatus::Parallel:
+      return "parallel lines";
+    case FitStatus::NoSolution:
+      return "points do not determine the figure";
+  }
+
+  return "unknown status";
+}
+
+/**
+ * @class Result result.h
+ *
+ * @brief Value or status of a failed operation
+ *
+ * Lightweight counterpart of std::expected holding the value in place, so
+ * neither success nor failure allocates memory or throws. The value of a
+ * failed result is default constructed.
+ */
+template <typename T>
+class Result
+{
+public:
+
+  /**
+   * @brief Construction of successful result
+   *
+   * @param value is the resulting value
+   */
+  Result(const T& value) :
+    value_(value),
+    status_(FitStatus::Ok)
+  {}
+
+  /**
+   * @brief Construction of failed result
+   *
+   * @param status is the reason of the failure
+   */
+  Result(FitStatus status) :
+    value_(),
+    status_(status)
+  {}
+
+  /**
+   * @brief Check if the operation succeeded
+   */
+  bool ok() const {
+    return status_ == FitStatus::Ok;
+  }
+
+  /**
+   * @brief Check if the operation succeeded
+   */
+  explicit operator bool() const {
+    return ok();
+  }
+
+  /**
+   * @brief Get status of the operation
+   */
+  FitStatus status() const {
+    return status_;
+  }
+
+  /**
+   * @brief Get the value
+   *
+   * @throw std::logic_error if the operation failed
+   */
+  const T& value() const {
+    if (!ok())
+      throw std::logic_error(toString(status_));
+
+    return value_;
+  }
+
+  /**
+   * @brief Get the value or a fallback if the operation failed
+   */
+  T valueOr(const T& fallback) const {
+    return ok() ? value_ : fallback;
+  }
+
+  /**
+   * @brief Get the value without checking the status
+   */
+  const T& operator*() const {
+    return value_;
+  }
+
+  /**
+   * @brief Access the value without checking the status
+   */
+  const T* operator->() const {
+    return &value_;
+  }
+
+private:
+
+  T value_;             /**< @brief Resulting value */
+  FitStatus status_;    /**< @brief Status of the operation */
+};
+
+} // end namespace figfit
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory_resource>
+#include <vector>
+
 #include "../figures/line.h"
 
 namespace figfit
@@ -48,6 +51,23 @@ public:
     end_point_(end)
   {}
 
+  /**
+   * @brief Create segment from two points without throwing
+   *
+   * @param start is a start-point of the segment
+   * @param end is a end-point of the segment
+   *
+   * @return segment or FitStatus::Degenerate if start = end
+   *
+   * @sa Segment(const Point&, const Point&)
+   */
+  static Result<Segment> tryCreate(const Point& start, const Point& end) {
+    if (start == end)
+      return FitStatus::Degenerate;
+
+    return Segment(start, end);
+  }
+
   //
   // Inherited methods
   //
@@ -148,6 +168,23 @@ public:
     return a.dot(b) / length_squared;
   }
 
+  /**
+   * @brief Get parametric representation of a point without throwing
+   *
+   * @param p is a given point
+   *
+   * @return parameter t or FitStatus::Degenerate if length of this segment is
+   * zero
+   *
+   * @sa parametricRepresentation()
+   */
+  Result<double> tryParametricRepresentation(const Point& p) const {
+    if (lengthSquared() == 0.0)
+      return FitStatus::Degenerate;
+
+    return parametricRepresentation(p);
+  }
+
   /**
    * @brief Get squared length of this segment
    *
@@ -223,4 +260,18 @@ private:
   Point end_point_;     /**< @brief End of the segment */
 };
 
+/**
+ * @brief Array of segments, e.g. edges of a polyline
+ */
+typedef std::vector<Segment> SegmentArray;
+
+namespace pmr {
+
+/**
+ * @brief Array of segments taking memory from a std::pmr::memory_resource
+ */
+typedef std::pmr::vector<Segment> SegmentArray;
+
+} // end namespace pmr
+
 } // end namespace figfit
@@ -4,6 +4,8 @@
 #include <ostream>
 #include <stdexcept>
 
+#include "result.h"
+
 namespace figfit
 {
 
@@ -245,6 +247,22 @@ struct Vec
     return v.normalized();
   }
 
+  /**
+   * @brief Get normalized copy of this vector without throwing
+   *
+   * @return normalized copy of this vector or FitStatus::Degenerate if the
+   * length of the vector is zero
+   *
+   * @sa normalized()
+   */
+  Result<Vec> tryNormalized() const {
+    double length = this->length();
+    if (length == 0.0)
+      return FitStatus::Degenerate;
+
+    return Vec(x / length, y / length);
+  }
+
   /**
    * @brief Rotate this vector
    *
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+namespace figfit
+{
+
+class FigureFitter;
+
+/**
+ * @class FitWorkspace fit_workspace.h
+ *
+ * @brief Reusable buffers of FigureFitter
+ *
+ * Holds the coordinates of points and the scratch buffers of the fits. The
+ * buffers only grow, hence once a workspace has served the largest point set,
+ * neither constructing a FigureFitter upon it nor fitting allocates memory.
+ * A workspace serves one FigureFitter at a time and must outlive it; use one
+ * workspace per thread.
+ */
+class FitWorkspace
+{
+public:
+
+  /**
+   * @brief Construction with storage for given number of points (default)
+   */
+  explicit FitWorkspace(size_t points = 0) {
+    reserve(points);
+  }
+
+  /**
+   * @brief Grow storage to given number of points
+   */
+  void reserve(size_t points) {
+    if (x_.size() < points) {
+      x_.resize(points);
+      y_.resize(points);
+      projections_.reserve(points);
+    }
+  }
+
+  /**
+   * @brief Get number of points the workspace holds without allocating
+   */
+  size_t capacity() const {
+    return x_.size();
+  }
+
+private:
+
+  friend class FigureFitter;
+
+  std::vector<double> x_;             /**< @brief Coordinates x of points */
+  std::vector<double> y_;             /**< @brief Coordinates y of points */
+  std::vector<double> projections_;   /**< @brief Buffer for projections */
+};
+
+} // end namespace figfit
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace figfit
+{
+
+/**
+ * @class FrameArena frame_arena.h
+ *
+ * @brief Monotonic memory resource rewound after each frame
+ *
+ * Bump-allocates memory from blocks obtained from the upstream resource.
+ * Deallocation does nothing; instead the whole arena is rewound with rewind()
+ * in O(1) once the frame is processed. Unlike the release() of
+ * std::pmr::monotonic_buffer_resource, rewinding keeps the blocks, hence after
+ * the first frames the arena serves all of the allocations without touching
+ * the upstream resource. Use it with the std::pmr containers, e.g.
+ * pmr::ClusterArray or PointCloud2D. The arena is not thread-safe.
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+
+  /**
+   * @brief Construction with given size of the first block (default)
+   *
+   * Blocks are obtained on demand, each one twice as large as the previous.
+   *
+   * @param block is the size of the first block in bytes
+   * @param upstream is the resource providing the blocks
+   */
+  explicit FrameArena(size_t block = 65536,
+                      std::pmr::memory_resource* upstream =
+                          std::pmr::get_default_resource()) :
+    upstream_(upstream),
+    block_(std::max<size_t>(block, 64)),
+    current_(0),
+    offset_(0),
+    used_(0)
+  {}
+
+  FrameArena(const FrameArena& rhs) = delete;
+  FrameArena& operator=(const FrameArena& rhs) = delete;
+
+  /**
+   * @brief Destruction (returns the blocks to the upstream resource)
+   */
+  ~FrameArena() {
+    for (const Block& b : blocks_)
+      upstream_->deallocate(b.data, b.size, alignof(std::max_align_t));
+  }
+
+  /**
+   * @brief Make all of the memory available again
+   *
+   * Every object allocated from the arena must be destroyed beforehand.
+   */
+  void rewind() {
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+  }
+
+  /**
+   * @brief Get number of bytes allocated since the last rewind
+   */
+  size_t used() const {
+    return used_;
+  }
+
+  /**
+   * @brief Get total size of the blocks in bytes
+   */
+  size_t capacity() const {
+    size_t size = 0;
+    for (const Block& b : blocks_)
+      size += b.size;
+    return size;
+  }
+
+protected:
+
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    for (;;) {
+      if (current_ < blocks_.size()) {
+        const Block& b = blocks_[current_];
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+        size_t start = ((base + offset_ + alignment - 1) & ~(alignment - 1)) -
+                       base;
+
+        if (start + bytes <= b.size) {
+          offset_ = start + bytes;
+          used_ += bytes;
+          return static_cast<char*>(b.data) + start;
+        }
+
+        current_++;
+        offset_ = 0;
+        continue;
+      }
+
+      size_t size = blocks_.empty() ? block_ : 2 * blocks_.back().size;
+      size = std::max(size, bytes + alignment);
+      blocks_.push_back(Block{upstream_->allocate(size,
+                                                  alignof(std::max_align_t)),
+                              size});
+    }
+  }
+
+  void do_deallocate(void*, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override {
+    return this == &other;
+  }
+
+private:
+
+  /**
+   * @struct Block
+   *
+   * @brief Block of memory obtained from the upstream resource
+   */
+  struct Block
+  {
+    void* data;   /**< @brief Pointer to the memory */
+    size_t size;  /**< @brief Size of the memory in bytes */
+  };
+
+  std::pmr::memory_resource* upstream_;   /**< @brief Source of blocks */
+  size_t block_;                          /**< @brief Size of the first block */
+
+  std::vector<Block> blocks_;   /**< @brief Blocks in order of creation */
+  size_t current_;              /**< @brief Index of the block in use */
+  size_t offset_;               /**< @brief Bytes taken from current block */
+  size_t used_;                 /**< @brief Bytes allocated since rewind */
+};
+
+} // end namespace figfit
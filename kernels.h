@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+
+namespace figfit
+{
+
+namespace kernels
+{
+
+/**
+ * @brief Instruction set level of the kernels
+ */
+enum class Isa
+{
+  Baseline,   /**< @brief Portable code, SSE2 on x86-64 */
+  AVX2,       /**< @brief 256-bit vectors */
+  AVX512      /**< @brief 512-bit vectors */
+};
+
+/**
+ * @struct KernelTable kernels.h
+ *
+ * @brief Hot loops over coordinate arrays compiled for one instruction set
+ *
+ * The figfit library compiles the same kernel source once per instruction
+ * set level and active() picks the best table supported by the processor at
+ * run time. The kernels accumulate in a fixed number of lanes combined in a
+ * fixed order and are compiled without contraction into fused multiply-adds,
+ * hence all of the levels give bit-identical results.
+ */
+struct KernelTable
+{
+  Isa isa;  /**< @brief Instruction set level of the table */
+
+  /**
+   * @brief Find centroid and centered second order sums of a point set
+   *
+   * @param sums is a placeholder for mean_x, mean_y, s_xx, s_xy, s_yy
+   */
+  void (*moments)(const double* x, const double* y, size_t n,
+                  double sums[5]);
+
+  /**
+   * @brief Find centroid and centered sums of a point set up to third order
+   *
+   * @param sums is a placeholder for mean_x, mean_y, s_xx, s_xy, s_yy, s_xxx,
+   * s_xxy, s_xyy, s_yyy
+   */
+  void (*cubicMoments)(const double* x, const double* y, size_t n,
+                       double sums[9]);
+
+  /**
+   * @brief Find sum of squared values of Ax + By + C over a point set
+   *
+   * For a line with unit normal (A, B) it is the sum of squared distances.
+   */
+  double (*lineDistanceSquared)(const double* x, const double* y, size_t n,
+                                double A, double B, double C);
+
+  /**
+   * @brief Find sum of squared distances of a point set to a circle
+   */
+  double (*circleDistanceSquared)(const double* x, const double* y, size_t n,
+                                  double center_x, double center_y,
+                                  double radius);
+
+  /**
+   * @brief Count points of a point set within an annulus
+   *
+   * A point is counted if its squared distance from the center lies in range
+   * [lower, upper].
+   */
+  size_t (*countInAnnulus)(const double* x, const double* y, size_t n,
+                           double center_x, double center_y,
+                           double lower, double upper);
+
+  /**
+   * @brief Find sums of a Gauss-Newton step for the center of a circle of
+   * known radius
+   *
+   * Only the points closer to the circumference than the threshold and apart
+   * from the center are taken into account. With the unit vector u from the
+   * center to a point and its residual r = |p - center| - radius, the sums
+   * are those of u_x^2, u_x u_y, u_y^2, u_x r, u_y r and r^2.
+   *
+   * @param sums is a placeholder for the six sums
+   *
+   * @return number of points taken into account
+   */
+  size_t (*circleCenterStep)(const double* x, const double* y, size_t n,
+                             double center_x, double center_y, double radius,
+                             double threshold, double sums[6]);
+
+  /**
+   * @brief Project a point set onto a line
+   *
+   * Finds the parameters t = dir_x * x + dir_y * y of the projections, their
+   * bounds and the sum of squared values of Ax + By + C in one pass.
+   *
+   * @param t is a placeholder for the parameters or nullptr if they are not
+   * needed
+   * @param bounds is a placeholder for the minimal and maximal parameter
+   *
+   * @return sum of squared values of Ax + By + C
+   */
+  double (*projectOntoLine)(const double* x, const double* y, size_t n,
+                            double A, double B, double C,
+                            double dir_x, double dir_y,
+                            double* t, double bounds[2]);
+
+  /**
+   * @brief Apply rotation by (c, s) and translation by (t_x, t_y)
+   *
+   * The output arrays may be the same as the input arrays.
+   */
+  void (*transform)(const double* x_in, const double* y_in, size_t n,
+                    double c, double s, double t_x, double t_y,
+                    double* x_out, double* y_out);
+};
+
+/**
+ * @brief Get kernels of the best instruction set level of the processor
+ *
+ * The level is detected from CPUID on the first call. It can be lowered with
+ * the FIGFIT_ISA environment variable set to baseline, avx2 or avx512, e.g.
+ * to compare the levels on one machine.
+ */
+const KernelTable& active();
+
+/**
+ * @brief Get kernels of given instruction set level
+ *
+ * @return pointer to the table or nullptr if the level was not compiled into
+ * the library or the processor does not support it
+ */
+const KernelTable* find(Isa isa);
+
+/**
+ * @brief Get name of instruction set level
+ */
+const char* toString(Isa isa);
+
+} // end namespace kernels
+
+} // end namespace figfit
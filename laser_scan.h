@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "../point_cloud.h"
+
+namespace figfit
+{
+
+/**
+ * @struct LaserScan laser_scan.h
+ *
+ * @brief Range scan of a planar lidar
+ *
+ * Structure containing ranges measured along beams spread with a constant
+ * angular increment, starting from angle_min. The angles are measured in the
+ * sensor frame in a counter-clockwise direction. Ranges outside of
+ * [range_min, range_max], infinite or NaN ranges are invalid.
+ */
+struct LaserScan
+{
+  double angle_min;         /**< @brief Angle of the first beam in radians */
+  double angle_increment;   /**< @brief Angle between beams in radians */
+  double range_min;         /**< @brief Minimal valid range */
+  double range_max;         /**< @brief Maximal valid range */
+  std::vector<double> ranges;   /**< @brief Measured ranges, one per beam */
+
+  /**
+   * @brief Construction from scan parameters (default)
+   *
+   * @param angle_min is the angle of the first beam in radians
+   * @param angle_increment is the angle between beams in radians
+   * @param range_min is the minimal valid range
+   * @param range_max is the maximal valid range
+   */
+  LaserScan(double angle_min = 0.0, double angle_increment = 0.0,
+            double range_min = 0.0,
+            double range_max = std::numeric_limits<double>::max()) :
+    angle_min(angle_min),
+    angle_increment(angle_increment),
+    range_min(range_min),
+    range_max(range_max)
+  {}
+};
+
+/**
+ * @class ScanConverter laser_scan.h
+ *
+ * @brief Conversion of range scans into point clouds
+ *
+ * Keeps tables of cosines and sines of beam angles, keyed by the angle of the
+ * first beam, the angular increment and the number of beams. A table is
+ * computed the first time a scan with the given key is converted and reused
+ * afterwards, hence no trigonometric functions are evaluated per scan. Tables
+ * of several sensors can be kept in one converter.
+ */
+class ScanConverter
+{
+public:
+
+  /**
+   * @brief Convert scan into point cloud
+   *
+   * Converts all of the ranges in one pass, which multiplies the ranges by the
+   * tabled cosines and sines and drops invalid beams. Points of invalid beams
+   * are overwritten by the next valid ones instead of branching, so that the
+   * loop runs at a constant cost per beam. The storage of the cloud is reused
+   * if its capacity suffices.
+   *
+   * @param scan is the scan to be converted
+   * @param cloud is a placeholder for the points of valid beams
+   */
+  void convert(const LaserScan& scan, PointCloud2D& cloud) {
+    convert(scan, cloud, static_cast<std::vector<size_t>*>(nullptr));
+  }
+
+  /**
+   * @brief Convert scan into point cloud and get beam indices
+   *
+   * @param scan is the scan to be converted
+   * @param cloud is a placeholder for the points of valid beams
+   * @param beams is a placeholder for the indices of beams of the points, any
+   * vector of indices, e.g. std::pmr::vector<size_t>
+   *
+   * @sa convert(const LaserScan&, PointCloud2D&)
+   */
+  template <typename Allocator>
+  void convert(const LaserScan& scan, PointCloud2D& cloud,
+               std::vector<size_t, Allocator>& beams) {
+    convert(scan, cloud, &beams);
+  }
+
+  /**
+   * @brief Get number of cached tables
+   */
+  size_t tables() const {
+    return tables_.size();
+  }
+
+private:
+
+  /**
+   * @struct DirectionTable
+   *
+   * @brief Cosines and sines of beam angles of one scan geometry
+   */
+  struct DirectionTable
+  {
+    double angle_min;             /**< @brief Key: angle of the first beam */
+    double angle_increment;       /**< @brief Key: angle between beams */
+    std::vector<double> cosines;  /**< @brief Cosines of beam angles */
+    std::vector<double> sines;    /**< @brief Sines of beam angles */
+  };
+
+  /**
+   * @brief Find table matching the scan or create a new one
+   */
+  const DirectionTable& findTable(const LaserScan& scan) {
+    const size_t n = scan.ranges.size();
+
+    for (const DirectionTable& t : tables_)
+      if (t.angle_min == scan.angle_min &&
+          t.angle_increment == scan.angle_increment &&
+          t.cosines.size() == n)
+        return t;
+
+    DirectionTable table;
+    table.angle_min = scan.angle_min;
+    table.angle_increment = scan.angle_increment;
+    table.cosines.resize(n);
+    table.sines.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+      double angle = scan.angle_min + i * scan.angle_increment;
+      table.cosines[i] = cos(angle);
+      table.sines[i] = sin(angle);
+    }
+
+    tables_.push_back(std::move(table));
+    return tables_.back();
+  }
+
+  /**
+   * @brief Convert scan into point cloud and optionally get beam indices
+   */
+  template <typename Beams>
+  void convert(const LaserScan& scan, PointCloud2D& cloud, Beams* beams) {
+    const DirectionTable& table = findTable(scan);
+    const size_t n = scan.ranges.size();
+
+    cloud.resize(n);
+    if (beams)
+      beams->resize(n);
+
+    const double* r = scan.ranges.data();
+    const double* c = table.cosines.data();
+    const double* s = table.sines.data();
+    double* x = cloud.xData();
+    double* y = cloud.yData();
+
+    // NaN fails both comparisons, infinity fails the upper one
+    const double r_min = scan.range_min;
+    const double r_max = scan.range_max;
+
+    size_t k = 0;
+    if (beams) {
+      size_t* b = beams->data();
+      for (size_t i = 0; i < n; ++i) {
+        x[k] = r[i] * c[i];
+        y[k] = r[i] * s[i];
+        b[k] = i;
+        k += (r[i] >= r_min && r[i] <= r_max);
+      }
+      beams->resize(k);
+    }
+    else {
+      for (size_t i = 0; i < n; ++i) {
+        x[k] = r[i] * c[i];
+        y[k] = r[i] * s[i];
+        k += (r[i] >= r_min && r[i] <= r_max);
+      }
+    }
+
+    cloud.resize(k);
+  }
+
+  std::vector<DirectionTable> tables_;  /**< @brief Cached direction tables */
+};
+
+} // end namespace figfit
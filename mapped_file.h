@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace figfit
+{
+
+/**
+ * @class MappedFile mapped_file.h
+ *
+ * @brief Read-only memory mapping of a whole file
+ *
+ * The mapping is released on destruction. An empty file gives an empty
+ * mapping with a null data pointer.
+ */
+class MappedFile
+{
+public:
+
+  /**
+   * @brief Construction with mapping of a file
+   *
+   * @param path is the path of the file
+   *
+   * @throw std::runtime_error if the file cannot be opened or mapped
+   */
+  explicit MappedFile(const std::string& path) :
+    data_(nullptr), size_(0)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Could not open file " + path);
+
+    struct stat status;
+    bool failed = (fstat(fd, &status) != 0);
+
+    if (!failed && status.st_size > 0) {
+      size_ = status.st_size;
+      void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      failed = (data == MAP_FAILED);
+      data_ = failed ? nullptr : static_cast<const char*>(data);
+    }
+    ::close(fd);
+
+    if (failed)
+      throw std::runtime_error("Could not map file " + path);
+  }
+
+  MappedFile(const MappedFile& rhs) = delete;
+  MappedFile& operator=(const MappedFile& rhs) = delete;
+
+  /**
+   * @brief Destruction (unmaps the file)
+   */
+  ~MappedFile() {
+    if (data_)
+      munmap(const_cast<char*>(data_), size_);
+  }
+
+  /**
+   * @brief Get pointer to the first byte of the file
+   */
+  const char* data() const {
+    return data_;
+  }
+
+  /**
+   * @brief Get size of the file in bytes
+   */
+  size_t size() const {
+    return size_;
+  }
+
+private:
+
+  const char* data_;  /**< @brief Mapped file */
+  size_t size_;       /**< @brief Size of the file */
+};
+
+} // end namespace figfit
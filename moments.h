@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "../kernels.h"
+
+namespace figfit
+{
+
+/**
+ * @struct Moments moments.h
+ *
+ * @brief Scatter moments of a point set
+ *
+ * Structure containing the sample size, the centroid and the sums of centered
+ * products of coordinates of a point set. The sums are taken about the
+ * centroid, which keeps them well conditioned for point sets located far from
+ * (0,0). Most of the least squares fits can be computed from these values
+ * alone, without revisiting the points.
+ */
+struct Moments
+{
+  size_t n;       /**< @brief Number of points */
+  double mean_x;  /**< @brief Mean of x coordinates */
+  double mean_y;  /**< @brief Mean of y coordinates */
+  double s_xx;    /**< @brief Sum of (x - mean_x)^2 */
+  double s_xy;    /**< @brief Sum of (x - mean_x) * (y - mean_y) */
+  double s_yy;    /**< @brief Sum of (y - mean_y)^2 */
+
+  /**
+   * @brief Construction of empty moments (default)
+   */
+  Moments() :
+    n(0), mean_x(0.0), mean_y(0.0), s_xx(0.0), s_xy(0.0), s_yy(0.0)
+  {}
+
+  /**
+   * @brief Add a point to the moments
+   *
+   * Uses the Welford update, hence the point set can be processed in a single
+   * pass.
+   *
+   * @param x is an abscissa coordinate of the point
+   * @param y is an ordinate coordinate of the point
+   */
+  void add(double x, double y) {
+    n++;
+    double dx = x - mean_x;
+    double dy = y - mean_y;
+    mean_x += dx / n;
+    mean_y += dy / n;
+    s_xx += dx * (x - mean_x);
+    s_xy += dx * (y - mean_y);
+    s_yy += dy * (y - mean_y);
+  }
+
+  /**
+   * @brief Add a block of points to the moments
+   *
+   * Finds the moments of the block in two passes, which is more accurate and
+   * faster than adding the points one by one, and merges them. The passes run
+   * in the vectorized kernel of kernels::active().
+   *
+   * @param x is a pointer to the array of x coordinates
+   * @param y is a pointer to the array of y coordinates
+   * @param size is the number of points
+   */
+  void addBlock(const double* x, const double* y, size_t size) {
+    if (size == 0)
+      return;
+
+    double sums[5];
+    kernels::active().moments(x, y, size, sums);
+
+    Moments block;
+    block.n = size;
+    block.mean_x = sums[0];
+    block.mean_y = sums[1];
+    block.s_xx = sums[2];
+    block.s_xy = sums[3];
+    block.s_yy = sums[4];
+
+    merge(block);
+  }
+
+  /**
+   * @brief Merge moments of another, disjoint point set into these moments
+   *
+   * Uses the pairwise update of T. F. Chan, G. H. Golub and R. J. LeVeque,
+   * which shifts both sums to the combined centroid and stays accurate when
+   * the sets are large. Merging in a fixed order gives bit-identical results.
+   *
+   * @param other is the moments of the other point set
+   */
+  void merge(const Moments& other) {
+    if (other.n == 0)
+      return;
+    if (n == 0) {
+      *this = other;
+      return;
+    }
+
+    double n_a = n, n_b = other.n, n_ab = n_a + n_b;
+    double dx = other.mean_x - mean_x;
+    double dy = other.mean_y - mean_y;
+    double w = n_a * n_b / n_ab;
+
+    s_xx += other.s_xx + dx * dx * w;
+    s_xy += other.s_xy + dx * dy * w;
+    s_yy += other.s_yy + dy * dy * w;
+    mean_x += dx * n_b / n_ab;
+    mean_y += dy * n_b / n_ab;
+    n += other.n;
+  }
+
+  /**
+   * @brief Get angle of the principal axis
+   *
+   * The principal axis is the direction of the greatest spread of points, i.e.
+   * the direction of the orthogonal regression line.
+   *
+   * @return angle of the principal axis in radians, in range [-pi/2, pi/2]
+   */
+  double principalAngle() const {
+    return 0.5 * atan2(2.0 * s_xy, s_xx - s_yy);
+  }
+
+  /**
+   * @brief Get anisotropy of the scatter
+   *
+   * @return difference between the greater and the smaller eigenvalue of the
+   * scatter matrix
+   */
+  double anisotropy() const {
+    return sqrt((s_xx - s_yy) * (s_xx - s_yy) + 4.0 * s_xy * s_xy);
+  }
+
+  /**
+   * @brief Get sum of squared distances of points to a line through centroid
+   *
+   * @param normal_x is an abscissa coordinate of the unit normal of the line
+   * @param normal_y is an ordinate coordinate of the unit normal of the line
+   *
+   * @return sum of squared distances of points to the line
+   */
+  double residualAlong(double normal_x, double normal_y) const {
+    return normal_x * normal_x * s_xx + 2.0 * normal_x * normal_y * s_xy +
+           normal_y * normal_y * s_yy;
+  }
+};
+
+/**
+ * @struct CubicMoments moments.h
+ *
+ * @brief Scatter moments of a point set up to the third order
+ *
+ * Extends Moments with the sums of centered products of the third order,
+ * which the algebraic circle fit needs in addition to the second order ones.
+ */
+struct CubicMoments : public Moments
+{
+  double s_xxx;   /**< @brief Sum of (x - mean_x)^3 */
+  double s_xxy;   /**< @brief Sum of (x - mean_x)^2 * (y - mean_y) */
+  double s_xyy;   /**< @brief Sum of (x - mean_x) * (y - mean_y)^2 */
+  double s_yyy;   /**< @brief Sum of (y - mean_y)^3 */
+
+  /**
+   * @brief Construction of empty moments (default)
+   */
+  CubicMoments() :
+    s_xxx(0.0), s_xxy(0.0), s_xyy(0.0), s_yyy(0.0)
+  {}
+
+  /**
+   * @brief Add a point to the moments
+   *
+   * @param x is an abscissa coordinate of the point
+   * @param y is an ordinate coordinate of the point
+   */
+  void add(double x, double y) {
+    CubicMoments point;
+    point.n = 1;
+    point.mean_x = x;
+    point.mean_y = y;
+    merge(point);
+  }
+
+  /**
+   * @brief Add a block of points to the moments
+   *
+   * @param x is a pointer to the array of x coordinates
+   * @param y is a pointer to the array of y coordinates
+   * @param size is the number of points
+   *
+   * @sa Moments::addBlock()
+   */
+  void addBlock(const double* x, const double* y, size_t size) {
+    if (size == 0)
+      return;
+
+    double sums[9];
+    kernels::active().cubicMoments(x, y, size, sums);
+
+    CubicMoments block;
+    block.n = size;
+    block.mean_x = sums[0];
+    block.mean_y = sums[1];
+    block.s_xx = sums[2];
+    block.s_xy = sums[3];
+    block.s_yy = sums[4];
+    block.s_xxx = sums[5];
+    block.s_xxy = sums[6];
+    block.s_xyy = sums[7];
+    block.s_yyy = sums[8];
+
+    merge(block);
+  }
+
+  /**
+   * @brief Merge moments of another, disjoint point set into these moments
+   *
+   * Uses the pairwise update of P. Pebay ("Formulas for Robust, One-Pass
+   * Parallel Computation of Covariances and Arbitrary-Order Statistical
+   * Moments") for the third order sums. Merging in a fixed order gives
+   * bit-identical results.
+   *
+   * @param other is the moments of the other point set
+   */
+  void merge(const CubicMoments& other) {
+    if (other.n == 0)
+      return;
+    if (n == 0) {
+      *this = other;
+      return;
+    }
+
+    double n_a = n, n_b = other.n, n_ab = n_a + n_b;
+    double dx = other.mean_x - mean_x;
+    double dy = other.mean_y - mean_y;
+    double w = n_a * n_b * (n_a - n_b) / (n_ab * n_ab);
+
+    // Differences of the second order sums weighted by the opposite sizes
+    double d_xx = (n_a * other.s_xx - n_b * s_xx) / n_ab;
+    double d_xy = (n_a * other.s_xy - n_b * s_xy) / n_ab;
+    double d_yy = (n_a * other.s_yy - n_b * s_yy) / n_ab;
+
+    s_xxx += other.s_xxx + dx * dx * dx * w + 3.0 * dx * d_xx;
+    s_xxy += other.s_xxy + dx * dx * dy * w + 2.0 * dx * d_xy + dy * d_xx;
+    s_xyy += other.s_xyy + dx * dy * dy * w + 2.0 * dy * d_xy + dx * d_yy;
+    s_yyy += other.s_yyy + dy * dy * dy * w + 3.0 * dy * d_yy;
+
+    Moments::merge(other);
+  }
+};
+
+} // end namespace figfit
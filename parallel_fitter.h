@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "../figure_fitter.h"
+#include "../kernels.h"
+#include "../moments.h"
+#include "../point_cloud.h"
+#include "../thread_pool.h"
+
+namespace figfit
+{
+
+/**
+ * @class ParallelFitter parallel_fitter.h
+ *
+ * @brief Line and circle fits of very large point sets on a ThreadPool
+ *
+ * The point set is split into one contiguous part per worker of the pool.
+ * Every part is reduced block by block into centered moments (two passes over
+ * a block that fits in cache), the parts are merged with the pairwise updates
+ * of Moments and CubicMoments and the figure is fitted from the result. The
+ * parts and the order of merging depend only on the number of workers, hence
+ * the result is bit-reproducible for a given pool size. Besides the points,
+ * the memory used is proportional to the number of workers.
+ */
+class ParallelFitter
+{
+public:
+
+  /**
+   * @brief Construction with given pool
+   *
+   * @param pool is the pool running the reductions, it must outlive the fitter
+   * @param block is the number of points reduced in two passes at once
+   */
+  explicit ParallelFitter(ThreadPool& pool, size_t block = 4096) :
+    pool_(pool),
+    block_(std::max<size_t>(block, 1))
+  {}
+
+  /**
+   * @brief Find moments of a point set
+   *
+   * @param points is the view of points
+   *
+   * @return scatter moments of the point set
+   */
+  Moments findMoments(const PointCloudView& points) const {
+    return reduce<Moments>(points);
+  }
+
+  /**
+   * @brief Find moments of a point set up to the third order
+   *
+   * @param points is the view of points
+   *
+   * @return scatter moments of the point set
+   */
+  CubicMoments findCubicMoments(const PointCloudView& points) const {
+    return reduce<CubicMoments>(points);
+  }
+
+  /**
+   * @brief Fit line to a point set
+   *
+   * Gives the line of FigureFitter::fitLine() up to rounding errors.
+   *
+   * @param points is the view of points
+   * @param l is a placeholder for the resulting line
+   *
+   * @throw std::logic_error if there are less than two points in the set
+   * @throw std::runtime_error if the line cannot be determined
+   */
+  void fitLine(const PointCloudView& points, Line& l) const {
+    FigureFitter::fitLine(findMoments(points), l);
+  }
+
+  /**
+   * @brief Fit line to a point set and get variance
+   *
+   * The variance is found from the moments, without another pass.
+   *
+   * @param points is the view of points
+   * @param l is a placeholder for the resulting line
+   * @param variance is a placeholder for the variance of points around line
+   */
+  void fitLine(const PointCloudView& points, Line& l, double& variance) const {
+    FigureFitter::fitLine(findMoments(points), l, variance);
+  }
+
+  /**
+   * @brief Fit circle to a point set
+   *
+   * Gives the circle of FigureFitter::fitCircle() up to rounding errors.
+   *
+   * @param points is the view of points
+   * @param c is a placeholder for the resulting circle
+   *
+   * @throw std::runtime_error if there are less than three points in the set
+   * or all of the points are collinear
+   */
+  void fitCircle(const PointCloudView& points, Circle& c) const {
+    FigureFitter::fitCircle(findCubicMoments(points), c);
+  }
+
+  /**
+   * @brief Fit circle to a point set and get variance
+   *
+   * The variance requires the second parallel pass over the points.
+   *
+   * @param points is the view of points
+   * @param c is a placeholder for the resulting circle
+   * @param variance is a placeholder for the variance of points around circle
+   */
+  void fitCircle(const PointCloudView& points, Circle& c,
+                 double& variance) const {
+    fitCircle(points, c);
+
+    const size_t parts = pool_.size();
+    std::vector<Padded<double>> sums(parts);
+
+    const Point center = c.center();
+    const double radius = c.radius();
+
+    pool_.parallelFor(parts, [&](size_t part, size_t) {
+      size_t first, last;
+      findPart(points.size(), part, first, last);
+
+      sums[part].value = kernels::active().circleDistanceSquared(
+          points.xData() + first, points.yData() + first, last - first,
+          center.x, center.y, radius);
+    });
+
+    variance = 0.0;
+    for (size_t part = 0; part < parts; ++part)
+      variance += sums[part].value;
+    variance /= points.size();
+  }
+
+  /**
+   * @brief Try to fit line to a point set
+   *
+   * @return status of FigureFitter::tryFitLine(const Moments&, Line&)
+   */
+  FitStatus tryFitLine(const PointCloudView& points, Line& l) const {
+    return FigureFitter::tryFitLine(findMoments(points), l);
+  }
+
+  /**
+   * @brief Try to fit line to a point set and get variance
+   *
+   * @return status of FigureFitter::tryFitLine(const Moments&, Line&)
+   */
+  FitStatus tryFitLine(const PointCloudView& points, Line& l,
+                       double& variance) const {
+    return FigureFitter::tryFitLine(findMoments(points), l, variance);
+  }
+
+  /**
+   * @brief Try to fit circle to a point set
+   *
+   * @return status of FigureFitter::tryFitCircle(const CubicMoments&, Circle&)
+   */
+  FitStatus tryFitCircle(const PointCloudView& points, Circle& c) const {
+    return FigureFitter::tryFitCircle(findCubicMoments(points), c);
+  }
+
+private:
+
+  /**
+   * @struct Padded
+   *
+   * @brief Value on a separate cache line
+   */
+  template <typename T>
+  struct alignas(64) Padded
+  {
+    T value;
+  };
+
+  /**
+   * @brief Find range of points of given part
+   */
+  void findPart(size_t n, size_t part, size_t& first, size_t& last) const {
+    const size_t parts = pool_.size();
+    first = n / parts * part + std::min(part, n % parts);
+    last = first + n / parts + (part < n % parts ? 1 : 0);
+  }
+
+  /**
+   * @brief Reduce points into moments in parallel
+   */
+  template <typename M>
+  M reduce(const PointCloudView& points) const {
+    const size_t parts = pool_.size();
+    std::vector<Padded<M>> partial(parts);
+
+    pool_.parallelFor(parts, [&](size_t part, size_t) {
+      size_t first, last;
+      findPart(points.size(), part, first, last);
+
+      for (size_t i = first; i < last; i += block_)
+        partial[part].value.addBlock(points.xData() + i, points.yData() + i,
+                                     std::min(block_, last - i));
+    });
+
+    M m;
+    for (size_t part = 0; part < parts; ++part)
+      m.merge(partial[part].value);
+
+    return m;
+  }
+
+  ThreadPool& pool_;  /**< @brief Pool running the reductions */
+  size_t block_;      /**< @brief Number of points of a block */
+};
+
+} // end namespace figfit
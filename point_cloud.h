@@ -0,0 +1,382 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <stdexcept>
+
+#include "../figures/point.h"
+
+namespace figfit
+{
+
+/**
+ * @class PointCloudView point_cloud.h
+ *
+ * @brief Non-owning view of a point set
+ *
+ * The view refers to two separate arrays of x and y coordinates (structure of
+ * arrays), which keeps the inner loops over points contiguous. It does not own
+ * the arrays, hence the owner must outlive the view. A view can be obtained
+ * from a PointCloud2D or created upon any external storage, e.g. a memory
+ * mapped file.
+ */
+class PointCloudView
+{
+public:
+
+  /**
+   * @brief Construction from coordinate arrays (default)
+   *
+   * @param x is a pointer to the array of x coordinates
+   * @param y is a pointer to the array of y coordinates
+   * @param size is the number of points
+   */
+  PointCloudView(const double* x = nullptr, const double* y = nullptr,
+                 size_t size = 0) :
+    x_(x), y_(y), size_(size)
+  {}
+
+  /**
+   * @brief Get number of points
+   */
+  size_t size() const {
+    return size_;
+  }
+
+  /**
+   * @brief Check if the view is empty
+   */
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief Get x coordinate of i-th point
+   */
+  double x(size_t i) const {
+    return x_[i];
+  }
+
+  /**
+   * @brief Get y coordinate of i-th point
+   */
+  double y(size_t i) const {
+    return y_[i];
+  }
+
+  /**
+   * @brief Get i-th point
+   */
+  Point point(size_t i) const {
+    return Point(x_[i], y_[i]);
+  }
+
+  /**
+   * @brief Get pointer to the array of x coordinates
+   */
+  const double* xData() const {
+    return x_;
+  }
+
+  /**
+   * @brief Get pointer to the array of y coordinates
+   */
+  const double* yData() const {
+    return y_;
+  }
+
+  /**
+   * @brief Get view of a range of points
+   *
+   * @param first is the index of the first point of the range
+   * @param last is the index past the last point of the range
+   *
+   * @return view of points [first, last)
+   *
+   * @throw std::out_of_range if the range exceeds this view
+   */
+  PointCloudView subview(size_t first, size_t last) const {
+    if (first > last || last > size_)
+      throw std::out_of_range("Range exceeds the point cloud view");
+
+    return PointCloudView(x_ + first, y_ + first, last - first);
+  }
+
+private:
+
+  const double* x_;   /**< @brief Array of x coordinates */
+  const double* y_;   /**< @brief Array of y coordinates */
+  size_t size_;       /**< @brief Number of points */
+};
+
+/**
+ * @class PointCloud2D point_cloud.h
+ *
+ * @brief Container of a point set
+ *
+ * Stores x and y coordinates of points in two separate vectors (structure of
+ * arrays). Unlike std::vector<Point>, it carries no per-point virtual table
+ * and lets the batch operations run over contiguous coordinates.
+ *
+ * The cloud is allocator-aware: the vectors take their memory from a
+ * std::pmr::memory_resource, by default the default resource. Clouds created
+ * upon a FrameArena, or stored in std::pmr containers using one, are
+ * bump-allocated.
+ */
+class PointCloud2D
+{
+public:
+
+  /**
+   * @brief Allocator of the coordinate vectors
+   */
+  typedef std::pmr::polymorphic_allocator<double> allocator_type;
+
+  //
+  // Constructors
+  //
+
+  /**
+   * @brief Construction of cloud with given number of points (default)
+   *
+   * @param size is the number of points, initialized to (0, 0)
+   * @param alloc is the allocator of the coordinate vectors
+   */
+  explicit PointCloud2D(size_t size = 0,
+                        const allocator_type& alloc = allocator_type()) :
+    x_(size, alloc),
+    y_(size, alloc)
+  {}
+
+  /**
+   * @brief Construction of empty cloud with given allocator
+   *
+   * @param alloc is the allocator of the coordinate vectors, e.g. a pointer to
+   * a FrameArena
+   */
+  explicit PointCloud2D(const allocator_type& alloc) :
+    x_(alloc),
+    y_(alloc)
+  {}
+
+  /**
+   * @brief Construction from vector of points
+   *
+   * @param points is the vector containing figfit::Point objects
+   * @param alloc is the allocator of the coordinate vectors
+   */
+  explicit PointCloud2D(const std::vector<Point>& points,
+                        const allocator_type& alloc = allocator_type()) :
+    x_(points.size(), alloc),
+    y_(points.size(), alloc)
+  {
+    for (size_t i = 0; i < points.size(); ++i) {
+      x_[i] = points[i].x;
+      y_[i] = points[i].y;
+    }
+  }
+
+  /**
+   * @brief Construction from view
+   *
+   * @param points is the view of points to be copied
+   * @param alloc is the allocator of the coordinate vectors
+   */
+  explicit PointCloud2D(const PointCloudView& points,
+                        const allocator_type& alloc = allocator_type()) :
+    x_(points.xData(), points.xData() + points.size(), alloc),
+    y_(points.yData(), points.yData() + points.size(), alloc)
+  {}
+
+  PointCloud2D(const PointCloud2D& rhs) = default;
+  PointCloud2D& operator=(const PointCloud2D& rhs) = default;
+
+  PointCloud2D(PointCloud2D&& rhs) = default;
+  PointCloud2D& operator=(PointCloud2D&& rhs) = default;
+
+  /**
+   * @brief Copy construction with given allocator
+   */
+  PointCloud2D(const PointCloud2D& rhs, const allocator_type& alloc) :
+    x_(rhs.x_, alloc),
+    y_(rhs.y_, alloc)
+  {}
+
+  /**
+   * @brief Move construction with given allocator
+   *
+   * The points are copied if the allocators differ.
+   */
+  PointCloud2D(PointCloud2D&& rhs, const allocator_type& alloc) :
+    x_(std::move(rhs.x_), alloc),
+    y_(std::move(rhs.y_), alloc)
+  {}
+
+  /**
+   * @brief Get allocator of the coordinate vectors
+   */
+  allocator_type get_allocator() const {
+    return x_.get_allocator();
+  }
+
+  //
+  // Container methods
+  //
+
+  /**
+   * @brief Get number of points
+   */
+  size_t size() const {
+    return x_.size();
+  }
+
+  /**
+   * @brief Check if the cloud is empty
+   */
+  bool empty() const {
+    return x_.empty();
+  }
+
+  /**
+   * @brief Reserve storage for given number of points
+   */
+  void reserve(size_t size) {
+    x_.reserve(size);
+    y_.reserve(size);
+  }
+
+  /**
+   * @brief Change number of points
+   *
+   * The storage is reallocated only when the size exceeds the capacity.
+   */
+  void resize(size_t size) {
+    x_.resize(size);
+    y_.resize(size);
+  }
+
+  /**
+   * @brief Remove all of the points but keep the storage
+   */
+  void clear() {
+    x_.clear();
+    y_.clear();
+  }
+
+  /**
+   * @brief Append point given by coordinates
+   */
+  void push_back(double x, double y) {
+    x_.push_back(x);
+    y_.push_back(y);
+  }
+
+  /**
+   * @brief Append point
+   */
+  void push_back(const Point& p) {
+    push_back(p.x, p.y);
+  }
+
+  //
+  // Access methods
+  //
+
+  /**
+   * @brief Get reference to x coordinate of i-th point
+   */
+  double& x(size_t i) {
+    return x_[i];
+  }
+
+  /**
+   * @brief Get x coordinate of i-th point
+   */
+  double x(size_t i) const {
+    return x_[i];
+  }
+
+  /**
+   * @brief Get reference to y coordinate of i-th point
+   */
+  double& y(size_t i) {
+    return y_[i];
+  }
+
+  /**
+   * @brief Get y coordinate of i-th point
+   */
+  double y(size_t i) const {
+    return y_[i];
+  }
+
+  /**
+   * @brief Get i-th point
+   */
+  Point point(size_t i) const {
+    return Point(x_[i], y_[i]);
+  }
+
+  /**
+   * @brief Get pointer to the array of x coordinates
+   */
+  double* xData() {
+    return x_.data();
+  }
+
+  /**
+   * @brief Get pointer to the array of x coordinates
+   */
+  const double* xData() const {
+    return x_.data();
+  }
+
+  /**
+   * @brief Get pointer to the array of y coordinates
+   */
+  double* yData() {
+    return y_.data();
+  }
+
+  /**
+   * @brief Get pointer to the array of y coordinates
+   */
+  const double* yData() const {
+    return y_.data();
+  }
+
+  /**
+   * @brief Get view of all of the points
+   */
+  PointCloudView view() const {
+    return PointCloudView(x_.data(), y_.data(), x_.size());
+  }
+
+  /**
+   * @brief Get view of a range of points
+   *
+   * @param first is the index of the first point of the range
+   * @param last is the index past the last point of the range
+   *
+   * @return view of points [first, last)
+   *
+   * @throw std::out_of_range if the range exceeds this cloud
+   */
+  PointCloudView view(size_t first, size_t last) const {
+    return view().subview(first, last);
+  }
+
+  /**
+   * @brief Implicit conversion to view of all of the points
+   */
+  operator PointCloudView() const {
+    return view();
+  }
+
+private:
+
+  std::pmr::vector<double> x_;  /**< @brief Vector of x coordinates */
+  std::pmr::vector<double> y_;  /**< @brief Vector of y coordinates */
+};
+
+} // end namespace figfit
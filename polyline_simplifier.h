@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "../point_cloud.h"
+#include "../figures/segment.h"
+
+namespace figfit
+{
+
+/**
+ * @class PolylineSimplifier polyline_simplifier.h
+ *
+ * @brief Simplification of polylines given by ordered point sets
+ *
+ * Reduces the number of vertices of a polyline, e.g. a contour of a scan, and
+ * returns the indices of retained vertices in increasing order. The first and
+ * the last point are always retained. The object keeps its buffers between
+ * calls, so a single instance can be reused for many polylines without
+ * reallocating.
+ */
+class PolylineSimplifier
+{
+public:
+
+  /**
+   * @brief Simplify polyline with the Douglas-Peucker algorithm
+   *
+   * A range of the polyline is replaced by the segment joining its end points
+   * if all of the points of the range lay closer to this segment than the
+   * tolerance. Otherwise the range is split at the farthest point. The ranges
+   * are processed with an explicit stack instead of recursion and the distances
+   * of a range are computed in one flat pass with the parametric form of the
+   * segment (cf. Segment::parametricRepresentation()).
+   *
+   * @param points is the view of ordered points
+   * @param tolerance is the maximal distance of removed points to the result
+   * @param vertices is a placeholder for the indices of retained points
+   */
+  void simplifyDouglasPeucker(const PointCloudView& points, double tolerance,
+                              std::vector<size_t>& vertices) {
+    vertices.clear();
+    const size_t n = points.size();
+    if (n < 3) {
+      for (size_t i = 0; i < n; ++i)
+        vertices.push_back(i);
+      return;
+    }
+
+    const double tolerance_squared = tolerance * tolerance;
+
+    retained_.assign(n, false);
+    retained_[0] = retained_[n - 1] = true;
+
+    ranges_.clear();
+    ranges_.push_back(std::make_pair(size_t(0), n - 1));
+
+    while (!ranges_.empty()) {
+      size_t first = ranges_.back().first;
+      size_t last = ranges_.back().second;
+      ranges_.pop_back();
+
+      if (last - first < 2)
+        continue;
+
+      double distance_squared;
+      size_t farthest = findFarthest(points, first, last, distance_squared);
+
+      if (distance_squared > tolerance_squared) {
+        retained_[farthest] = true;
+        ranges_.push_back(std::make_pair(first, farthest));
+        ranges_.push_back(std::make_pair(farthest, last));
+      }
+    }
+
+    for (size_t i = 0; i < n; ++i)
+      if (retained_[i])
+        vertices.push_back(i);
+  }
+
+  /**
+   * @brief Simplify polyline with the Visvalingam-Whyatt algorithm
+   *
+   * Repeatedly removes the vertex forming the triangle of the smallest area
+   * with its neighbours, until all of the areas are not less than the given
+   * one. The areas are kept in a binary heap. Entries made outdated by the
+   * removal of a neighbour are skipped when popped, so each removal costs
+   * O(log N).
+   *
+   * @param points is the view of ordered points
+   * @param area is the minimal area of triangles formed by retained vertices
+   * @param vertices is a placeholder for the indices of retained points
+   */
+  void simplifyVisvalingam(const PointCloudView& points, double area,
+                           std::vector<size_t>& vertices) {
+    vertices.clear();
+    const size_t n = points.size();
+    if (n < 3) {
+      for (size_t i = 0; i < n; ++i)
+        vertices.push_back(i);
+      return;
+    }
+
+    previous_.resize(n);
+    next_.resize(n);
+    areas_.resize(n);
+    heap_.clear();
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < n; ++i) {
+      previous_[i] = i - 1;
+      next_[i] = i + 1;
+      areas_[i] = (i == 0 || i == n - 1) ?
+            infinity : triangleArea(points, i - 1, i, i + 1);
+
+      if (areas_[i] < area)
+        heap_.push_back(std::make_pair(areas_[i], i));
+    }
+
+    auto greater = [](const HeapEntry& a, const HeapEntry& b) {
+      return a.first > b.first;
+    };
+    std::make_heap(heap_.begin(), heap_.end(), greater);
+
+    while (!heap_.empty()) {
+      std::pop_heap(heap_.begin(), heap_.end(), greater);
+      HeapEntry entry = heap_.back();
+      heap_.pop_back();
+
+      size_t i = entry.second;
+      if (entry.first != areas_[i])
+        continue;
+
+      // Unlink the vertex and update the areas of its neighbours
+      size_t p = previous_[i];
+      size_t q = next_[i];
+      next_[p] = q;
+      previous_[q] = p;
+      areas_[i] = -1.0;
+
+      for (size_t j : {p, q}) {
+        if (j == 0 || j == n - 1)
+          continue;
+
+        // The area never decreases, which keeps the order of removals stable
+        areas_[j] = std::max(entry.first,
+                             triangleArea(points, previous_[j], j, next_[j]));
+
+        if (areas_[j] < area) {
+          heap_.push_back(std::make_pair(areas_[j], j));
+          std::push_heap(heap_.begin(), heap_.end(), greater);
+        }
+      }
+    }
+
+    for (size_t i = 0; i < n; i = next_[i])
+      vertices.push_back(i);
+  }
+
+  /**
+   * @brief Convert simplified polyline into segments
+   *
+   * Consecutive vertices are joined with segments. Coinciding vertices are
+   * skipped, since segments of zero length are ill-defined.
+   *
+   * @param points is the view of ordered points
+   * @param vertices are the indices of vertices of the polyline
+   * @param segments is a placeholder for the resulting segments, any vector of
+   * segments, e.g. SegmentArray or pmr::SegmentArray
+   */
+  template <typename Allocator>
+  static void toSegments(const PointCloudView& points,
+                         const std::vector<size_t>& vertices,
+                         std::vector<Segment, Allocator>& segments) {
+    segments.clear();
+    if (vertices.empty())
+      return;
+
+    segments.reserve(vertices.size() - 1);
+
+    Point start = points.point(vertices[0]);
+    for (size_t i = 1; i < vertices.size(); ++i) {
+      Point end = points.point(vertices[i]);
+      if (end == start)
+        continue;
+
+      segments.push_back(Segment(start, end));
+      start = end;
+    }
+  }
+
+private:
+
+  typedef std::pair<double, size_t> HeapEntry;
+
+  /**
+   * @brief Find point of range farthest from the segment joining its ends
+   *
+   * @param points is the view of ordered points
+   * @param first is the index of the start point of the segment
+   * @param last is the index of the end point of the segment
+   * @param distance_squared is a placeholder for the squared distance of the
+   * farthest point
+   *
+   * @return index of the farthest point in range (first, last)
+   */
+  static size_t findFarthest(const PointCloudView& points, size_t first,
+                             size_t last, double& distance_squared) {
+    const double* x = points.xData();
+    const double* y = points.yData();
+
+    double x_0 = x[first];
+    double y_0 = y[first];
+    double a_x = x[last] - x_0;
+    double a_y = y[last] - y_0;
+    double length_squared = a_x * a_x + a_y * a_y;
+    double inverse = (length_squared > 0.0) ? 1.0 / length_squared : 0.0;
+
+    size_t farthest = first + 1;
+    distance_squared = -1.0;
+
+    for (size_t i = first + 1; i < last; ++i) {
+      double b_x = x[i] - x_0;
+      double b_y = y[i] - y_0;
+
+      double t = (a_x * b_x + a_y * b_y) * inverse;
+      t = (t < 0.0) ? 0.0 : (t > 1.0 ? 1.0 : t);
+
+      double d_x = b_x - t * a_x;
+      double d_y = b_y - t * a_y;
+      double d = d_x * d_x + d_y * d_y;
+
+      if (d > distance_squared) {
+        distance_squared = d;
+        farthest = i;
+      }
+    }
+
+    return farthest;
+  }
+
+  /**
+   * @brief Get area of triangle formed by three points
+   */
+  static double triangleArea(const PointCloudView& points,
+                             size_t a, size_t b, size_t c) {
+    double x_a = points.x(a), y_a = points.y(a);
+    return 0.5 * std::abs((points.x(b) - x_a) * (points.y(c) - y_a) -
+                          (points.y(b) - y_a) * (points.x(c) - x_a));
+  }
+
+  std::vector<bool> retained_;    /**< @brief Flags of retained points */
+  std::vector<std::pair<size_t, size_t>> ranges_; /**< @brief Stack of ranges */
+  std::vector<size_t> previous_;  /**< @brief Links to previous vertices */
+  std::vector<size_t> next_;      /**< @brief Links to next vertices */
+  std::vector<double> areas_;     /**< @brief Current areas of triangles */
+  std::vector<HeapEntry> heap_;   /**< @brief Heap of areas of triangles */
+};
+
+} // end namespace figfit
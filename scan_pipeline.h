@@ -0,0 +1,389 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../clustering.h"
+#include "../figure_fitter.h"
+#include "../frame_arena.h"
+#include "../laser_scan.h"
+#include "../spsc_queue.h"
+#include "../thread_pool.h"
+
+namespace figfit
+{
+
+/**
+ * @struct ScanFrame scan_pipeline.h
+ *
+ * @brief Buffers of a single scan passing through the ScanPipeline
+ *
+ * Frames are owned by the pipeline and recycled, so the vectors keep their
+ * capacity between scans and stop reallocating once they have grown to the
+ * size of the largest scan. The arena serves the per-frame temporaries of the
+ * consumer, e.g. pmr::SegmentArray of candidate figures, and is rewound when
+ * the frame is released.
+ */
+struct ScanFrame
+{
+  unsigned long sequence;       /**< @brief Number assigned by the producer */
+  double stamp;                 /**< @brief Time stamp of the scan */
+  LaserScan scan;               /**< @brief Input scan */
+  PointCloud2D cloud;           /**< @brief Points of valid beams */
+  std::vector<size_t> beams;    /**< @brief Beam index of each point */
+  ClusterArray clusters;        /**< @brief Clusters of points */
+  SegmentArray segments;        /**< @brief Segment fitted to each cluster */
+  std::vector<double> variances;  /**< @brief Variance of each segment */
+  FrameArena arena;             /**< @brief Memory of consumer temporaries */
+
+  /**
+   * @brief Construction (default)
+   */
+  ScanFrame() :
+    sequence(0), stamp(0.0)
+  {}
+};
+
+/**
+ * @class ScanPipeline scan_pipeline.h
+ *
+ * @brief Staged scan to clusters to figures pipeline
+ *
+ * Runs the conversion of scans into points, the clustering and the fitting of
+ * segments on three threads, one per stage. The stages pass pointers to
+ * frames through bounded SpscQueue objects, so each frame is processed by one
+ * stage at a time and no locks are taken. A fixed pool of frames is allocated
+ * upon construction and recycled: the producer takes a free frame with
+ * acquire(), fills its scan and hands it over with submit(); the consumer
+ * takes processed frames with receive() and returns them with release().
+ * Exactly one thread may act as the producer and exactly one as the consumer
+ * (it may be the same thread). When no frame is free, acquire() returns
+ * nullptr instead of blocking, which bounds the latency of the pipeline by the
+ * number of frames. A stage thread with an empty input queue spins for a short
+ * while to pick up the next frame with low latency and then sleeps until the
+ * previous stage wakes it up. The stage threads can be pinned to given cores.
+ *
+ * Each cluster is fitted with FigureFitter::fitSegment(). The segments and
+ * variances arrays are aligned with the clusters array. Clusters for which the
+ * fit fails get a default segment with infinite variance. If a ThreadPool is
+ * given, the fitting stage spreads the clusters of a frame over its workers.
+ * Every worker fits within its own FitWorkspace and ThreadPool::parallelFor()
+ * does not allocate, hence after the first frames the fitting stage does not
+ * allocate memory.
+ */
+class ScanPipeline
+{
+public:
+
+  /**
+   * @brief Construction with given clusterer and number of frames
+   *
+   * @param clusterer is the clustering used by the second stage
+   * @param frames is the number of preallocated frames
+   * @param points is the number of points reserved in each frame
+   * @param pool is an optional pool for fitting clusters in parallel, it must
+   * outlive the pipeline
+   *
+   * @throw std::logic_error if the number of frames is zero
+   */
+  ScanPipeline(const ScanClusterer& clusterer = ScanClusterer(),
+               size_t frames = 8, size_t points = 0,
+               ThreadPool* pool = nullptr) :
+    clusterer_(clusterer),
+    pool_(pool),
+    workspaces_(pool ? pool->size() : 1, FitWorkspace(points)),
+    free_(frames),
+    scans_(frames),
+    clouds_(frames),
+    clusters_(frames),
+    figures_(frames),
+    running_(false)
+  {
+    if (frames == 0)
+      throw std::logic_error("Pipeline requires at least one frame");
+
+    for (size_t i = 0; i < frames; ++i) {
+      frames_.emplace_back(new ScanFrame());
+      frames_.back()->scan.ranges.reserve(points);
+      frames_.back()->cloud.reserve(points);
+      frames_.back()->beams.reserve(points);
+      free_.push(frames_.back().get());
+    }
+  }
+
+  ScanPipeline(const ScanPipeline& rhs) = delete;
+  ScanPipeline& operator=(const ScanPipeline& rhs) = delete;
+
+  /**
+   * @brief Destruction (stops the stage threads)
+   */
+  ~ScanPipeline() {
+    stop();
+  }
+
+  /**
+   * @brief Start the stage threads
+   *
+   * @param cores are the cores of the conversion, clustering and fitting
+   * threads or an empty vector to leave the threads unpinned (Linux only)
+   *
+   * @throw std::logic_error if the cores are neither empty nor three
+   */
+  void start(const std::vector<size_t>& cores = std::vector<size_t>()) {
+    if (!cores.empty() && cores.size() != 3)
+      throw std::logic_error("Pipeline requires a core for each stage");
+
+    if (running_.exchange(true))
+      return;
+
+    threads_.emplace_back(&ScanPipeline::run, this, std::ref(scans_),
+                          std::ref(wakeups_[0]), std::ref(clouds_),
+                          &wakeups_[1], &ScanPipeline::convert);
+    threads_.emplace_back(&ScanPipeline::run, this, std::ref(clouds_),
+                          std::ref(wakeups_[1]), std::ref(clusters_),
+                          &wakeups_[2], &ScanPipeline::cluster);
+    threads_.emplace_back(&ScanPipeline::run, this, std::ref(clusters_),
+                          std::ref(wakeups_[2]), std::ref(figures_),
+                          nullptr, &ScanPipeline::fit);
+
+    for (size_t i = 0; i < cores.size(); ++i)
+      pinToCore(threads_[i], cores[i]);
+  }
+
+  /**
+   * @brief Stop the stage threads
+   *
+   * Frames being processed at the moment of stopping are finished and the
+   * queued ones stay queued until the pipeline is started again.
+   */
+  void stop() {
+    running_ = false;
+    for (Wakeup& wakeup : wakeups_) {
+      std::lock_guard<std::mutex> lock(wakeup.mutex);
+      wakeup.signal.notify_one();
+    }
+
+    for (std::thread& t : threads_)
+      t.join();
+    threads_.clear();
+  }
+
+  /**
+   * @brief Take a free frame (producer only)
+   *
+   * @return pointer to a free frame or nullptr if all of them are in use
+   */
+  ScanFrame* acquire() {
+    ScanFrame* frame;
+    return free_.pop(frame) ? frame : nullptr;
+  }
+
+  /**
+   * @brief Pass a filled frame to the pipeline (producer only)
+   *
+   * @param frame is a frame previously obtained from acquire()
+   */
+  void submit(ScanFrame* frame) {
+    scans_.push(frame);
+    wake(wakeups_[0]);
+  }
+
+  /**
+   * @brief Take a processed frame (consumer only)
+   *
+   * Frames are received in the order of submission.
+   *
+   * @return pointer to a processed frame or nullptr if there is none
+   */
+  ScanFrame* receive() {
+    ScanFrame* frame;
+    return figures_.pop(frame) ? frame : nullptr;
+  }
+
+  /**
+   * @brief Return a processed frame to the pool (consumer only)
+   *
+   * Rewinds the arena of the frame, hence every object allocated from it must
+   * be destroyed beforehand.
+   *
+   * @param frame is a frame previously obtained from receive()
+   */
+  void release(ScanFrame* frame) {
+    frame->arena.rewind();
+    free_.push(frame);
+  }
+
+  /**
+   * @brief Get number of frames
+   */
+  size_t frames() const {
+    return frames_.size();
+  }
+
+private:
+
+  typedef SpscQueue<ScanFrame*> FrameQueue;
+
+  /**
+   * @struct Wakeup
+   *
+   * @brief Sleeping place of a stage thread waiting for its input queue
+   */
+  struct Wakeup
+  {
+    std::mutex mutex;                 /**< @brief Guard of sleeping */
+    std::condition_variable signal;   /**< @brief Signal of a new frame */
+    std::atomic<bool> sleeping;       /**< @brief Flag of sleeping thread */
+
+    Wakeup() :
+      sleeping(false)
+    {}
+  };
+
+  /**
+   * @brief Number of polls of an empty input queue before sleeping
+   */
+  static const size_t spin_limit = 2048;
+
+  /**
+   * @brief Wake up stage thread after a push to its input queue
+   *
+   * The fence orders the push before the check of the flag, the stage thread
+   * orders the raise of the flag before its last check of the queue, so at
+   * least one of them sees the other. Locking the mutex ensures that a thread
+   * which has raised the flag is already waiting for the signal.
+   */
+  static void wake(Wakeup& wakeup) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!wakeup.sleeping.load(std::memory_order_relaxed))
+      return;
+
+    std::lock_guard<std::mutex> lock(wakeup.mutex);
+    wakeup.signal.notify_one();
+  }
+
+  /**
+   * @brief Loop of a stage thread
+   *
+   * Polls the input queue and, after spin_limit failed polls in a row, sleeps
+   * until the previous stage or stop() wakes it up. The output queue holds all
+   * of the frames, hence pushing to it never fails.
+   *
+   * @param input is the input queue of the stage
+   * @param wakeup is the sleeping place of the stage
+   * @param output is the output queue of the stage
+   * @param next is the sleeping place of the next stage or nullptr for the
+   * last stage, whose frames are polled by the consumer
+   * @param process is the processing of the stage
+   */
+  void run(FrameQueue& input, Wakeup& wakeup, FrameQueue& output,
+           Wakeup* next, void (ScanPipeline::*process)(ScanFrame&)) {
+    ScanFrame* frame;
+    size_t spins = 0;
+
+    while (running_.load(std::memory_order_relaxed)) {
+      if (input.pop(frame)) {
+        (this->*process)(*frame);
+        output.push(frame);
+        if (next)
+          wake(*next);
+        spins = 0;
+        continue;
+      }
+
+      if (++spins < spin_limit) {
+        pause();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(wakeup.mutex);
+      wakeup.sleeping.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      wakeup.signal.wait(lock, [this, &input] {
+        return input.size() > 0 || !running_;
+      });
+      wakeup.sleeping.store(false, std::memory_order_relaxed);
+      spins = 0;
+    }
+  }
+
+  /**
+   * @brief Hint to the processor of a spin-wait loop
+   */
+  static void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  /**
+   * @brief First stage: conversion of scan into points
+   */
+  void convert(ScanFrame& frame) {
+    converter_.convert(frame.scan, frame.cloud, frame.beams);
+  }
+
+  /**
+   * @brief Second stage: clustering of points
+   */
+  void cluster(ScanFrame& frame) {
+    clusterer_.cluster(frame.cloud, frame.clusters);
+  }
+
+  /**
+   * @brief Third stage: fitting of segments to clusters
+   */
+  void fit(ScanFrame& frame) {
+    const size_t n = frame.clusters.size();
+    frame.segments.resize(n);
+    frame.variances.resize(n);
+
+    if (pool_)
+      pool_->parallelFor(n, [this, &frame](size_t i, size_t worker) {
+        fitCluster(frame, i, workspaces_[worker]);
+      });
+    else
+      for (size_t i = 0; i < n; ++i)
+        fitCluster(frame, i, workspaces_[0]);
+  }
+
+  /**
+   * @brief Fit segment to i-th cluster of a frame
+   */
+  static void fitCluster(ScanFrame& frame, size_t i, FitWorkspace& workspace) {
+    FigureFitter fitter(frame.clusters[i].view(frame.cloud), workspace);
+    if (fitter.tryFitSegment(frame.segments[i], frame.variances[i],
+                             SegmentExtent::MinMax) != FitStatus::Ok) {
+      frame.segments[i] = Segment();
+      frame.variances[i] = std::numeric_limits<double>::infinity();
+    }
+  }
+
+  ScanConverter converter_;   /**< @brief Converter of the first stage */
+  ScanClusterer clusterer_;   /**< @brief Clusterer of the second stage */
+  ThreadPool* pool_;          /**< @brief Optional pool of the third stage */
+
+  std::vector<FitWorkspace> workspaces_;  /**< @brief Workspaces of fitting */
+
+  std::vector<std::unique_ptr<ScanFrame>> frames_;  /**< @brief Frame pool */
+
+  FrameQueue free_;       /**< @brief Frames ready to be acquired */
+  FrameQueue scans_;      /**< @brief Frames waiting for conversion */
+  FrameQueue clouds_;     /**< @brief Frames waiting for clustering */
+  FrameQueue clusters_;   /**< @brief Frames waiting for fitting */
+  FrameQueue figures_;    /**< @brief Frames ready to be received */
+
+  Wakeup wakeups_[3];     /**< @brief Sleeping places of the stages */
+
+  std::atomic<bool> running_;         /**< @brief Flag of running stages */
+  std::vector<std::thread> threads_;  /**< @brief Threads of the stages */
+};
+
+} // end namespace figfit
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace figfit
+{
+
+/**
+ * @class SpscQueue spsc_queue.h
+ *
+ * @brief Bounded lock-free single-producer single-consumer queue
+ *
+ * Ring buffer of preallocated slots, safe for exactly one pushing thread and
+ * exactly one popping thread. The capacity is rounded up to a power of two.
+ * The indices of the producer and the consumer live on separate cache lines
+ * and each side keeps a cached copy of the other index, so that the shared
+ * lines are touched only when the queue seems full or empty. Neither push()
+ * nor pop() allocates, blocks or throws.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+
+  /**
+   * @brief Construction with given capacity
+   *
+   * @param capacity is the minimal number of elements the queue can hold
+   */
+  explicit SpscQueue(size_t capacity) :
+    head_(0), tail_cache_(0), tail_(0), head_cache_(0)
+  {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+
+    buffer_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscQueue(const SpscQueue& rhs) = delete;
+  SpscQueue& operator=(const SpscQueue& rhs) = delete;
+
+  /**
+   * @brief Push element (producer only)
+   *
+   * @param value is the element to be pushed
+   *
+   * @return false if the queue is full
+   */
+  bool push(const T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_)
+        return false;
+    }
+
+    buffer_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Pop element (consumer only)
+   *
+   * @param value is a placeholder for the popped element
+   *
+   * @return false if the queue is empty
+   */
+  bool pop(T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_)
+        return false;
+    }
+
+    value = buffer_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Get approximate number of elements
+   *
+   * The value is exact only if neither side operates on the queue.
+   */
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Get capacity
+   */
+  size_t capacity() const {
+    return mask_ + 1;
+  }
+
+private:
+
+  static const size_t cache_line = 64;
+
+  alignas(cache_line) std::atomic<size_t> head_;  /**< @brief Consumer index */
+  size_t tail_cache_;     /**< @brief Consumer copy of the producer index */
+
+  alignas(cache_line) std::atomic<size_t> tail_;  /**< @brief Producer index */
+  size_t head_cache_;     /**< @brief Producer copy of the consumer index */
+
+  alignas(cache_line) std::vector<T> buffer_;     /**< @brief Slots */
+  size_t mask_;           /**< @brief Capacity minus one */
+};
+
+} // end namespace figfit
@@ -0,0 +1,961 @@
+#include <limits>
+#include <random>
+#include <string>
+
+#include "../figure_fitter.h"
+#include "../kernels.h"
+
+namespace figfit
+{
+
+void FigureFitter::fitPoint(Point& p) {
+  check(tryFitPoint(p), "point", true);
+}
+
+void FigureFitter::fitPoint(Point& p, double& variance) {
+  check(tryFitPoint(p, variance), "point", true);
+}
+
+FitStatus FigureFitter::tryFitPoint(Point& p) {
+  if (N_ < 1)
+    return FitStatus::TooFewPoints;
+
+  Moments m = findMoments();
+  p = Point(m.mean_x, m.mean_y);
+
+  return FitStatus::Ok;
+}
+
+FitStatus FigureFitter::tryFitPoint(Point& p, double& variance) {
+  FitStatus status = tryFitPoint(p);
+  if (status == FitStatus::Ok)
+    variance = findVarianceAbout(p);
+
+  return status;
+}
+
+void FigureFitter::fitLine(Line& l) {
+  check(tryFitLine(l), "line", true);
+}
+
+void FigureFitter::fitLine(Line& l, double& variance) {
+  check(tryFitLine(l, variance), "line", true);
+}
+
+FitStatus FigureFitter::tryFitLine(Line& l) {
+  return tryFitLine(findMoments(), l);
+}
+
+FitStatus FigureFitter::tryFitLine(Line& l, double& variance) {
+  FitStatus status = tryFitLine(l);
+  if (status == FitStatus::Ok)
+    variance = findVarianceAboutLine(l);
+
+  return status;
+}
+
+void FigureFitter::fitSegment(Segment& s) {
+  check(tryFitSegment(s), "segment", true, true);
+}
+
+void FigureFitter::fitSegment(Segment& s, double& variance) {
+  check(tryFitSegment(s, variance), "segment", true, true);
+}
+
+void FigureFitter::fitSegment(Segment& s, SegmentExtent extent, double trim) {
+  check(tryFitSegment(s, extent, trim), "segment", true,
+        extent == SegmentExtent::FirstLast);
+}
+
+void FigureFitter::fitSegment(Segment& s, double& variance,
+                              SegmentExtent extent, double trim) {
+  check(tryFitSegment(s, variance, extent, trim), "segment", true,
+        extent == SegmentExtent::FirstLast);
+}
+
+FitStatus FigureFitter::tryFitSegment(Segment& s) {
+  Line line;
+  FitStatus status = tryFitLine(line);
+  if (status != FitStatus::Ok)
+    return status;
+
+  Point first_point(x_coords_(0), y_coords_(0));
+  Point second_point(x_coords_(N_ - 1), y_coords_(N_ - 1));
+
+  first_point = line.findProjectionOf(first_point);
+  second_point = line.findProjectionOf(second_point);
+
+  if (first_point == second_point)
+    return FitStatus::Degenerate;
+
+  s = Segment(first_point, second_point);
+
+  return FitStatus::Ok;
+}
+
+FitStatus FigureFitter::tryFitSegment(Segment& s, double& variance) {
+  FitStatus status = tryFitSegment(s);
+  if (status == FitStatus::Ok)
+    variance = findVarianceAbout(s);
+
+//  // TODO: Experiment with that
+//  if (sqrt(variance) < 0.5 * s.length()) {
+//    Point new_start_point = s.createPointFromParam(sqrt(variance) / s.length());
+//    Point new_end_point = s.createPointFromParam(1.0 - sqrt(variance) / s.length());
+
+//    s = Segment(new_start_point, new_end_point);
+//  }
+
+  return status;
+}
+
+FitStatus FigureFitter::tryFitSegment(Segment& s, SegmentExtent extent,
+                                      double trim) {
+  double sum;
+  return tryFitSegment(s, sum, extent, trim, false);
+}
+
+FitStatus FigureFitter::tryFitSegment(Segment& s, double& variance,
+                                      SegmentExtent extent, double trim) {
+  return tryFitSegment(s, variance, extent, trim, true);
+}
+
+FitStatus FigureFitter::tryFitSegment(Segment& s, double& variance,
+                                      SegmentExtent extent, double trim,
+                                      bool find_variance) {
+  if (extent == SegmentExtent::FirstLast)
+    return find_variance ? tryFitSegment(s, variance) : tryFitSegment(s);
+
+  Line line;
+  FitStatus status = tryFitLine(line);
+  if (status != FitStatus::Ok)
+    return status;
+
+  double sum;
+  status = findSegmentAlong(line, extent, trim, s, sum);
+  if (status == FitStatus::Ok)
+    variance = sum / N_;
+
+  return status;
+}
+
+double FigureFitter::findVarianceAboutLine(const Line& l) const {
+  return kernels::active().lineDistanceSquared(x_coords_.memptr(),
+                                               y_coords_.memptr(), N_,
+                                               l.A(), l.B(), l.C()) / N_;
+}
+
+double FigureFitter::findVarianceAboutCircle(const Circle& c) const {
+  return kernels::active().circleDistanceSquared(x_coords_.memptr(),
+                                                 y_coords_.memptr(), N_,
+                                                 c.center().x, c.center().y,
+                                                 c.radius()) / N_;
+}
+
+FitStatus FigureFitter::findSegmentAlong(const Line& line,
+                                         SegmentExtent extent, double trim,
+                                         Segment& s, double& sum) {
+  if (trim < 0.0 || trim >= 0.5)
+    return FitStatus::InvalidArgument;
+
+  const double A = line.A();
+  const double B = line.B();
+  const double C = line.C();
+
+  // The supporting line is parametrized as foot + t * (dir_x, dir_y), where
+  // foot is the projection of (0,0). Since foot is parallel to the normal,
+  // the parameter of point p is simply t = dir * p.
+  double dir_x = -B;
+  double dir_y = A;
+  if (dir_x * (x_coords_(N_ - 1) - x_coords_(0)) +
+      dir_y * (y_coords_(N_ - 1) - y_coords_(0)) < 0.0) {
+    dir_x = -dir_x;
+    dir_y = -dir_y;
+  }
+
+  const double* x = x_coords_.memptr();
+  const double* y = y_coords_.memptr();
+
+  const kernels::KernelTable& table = kernels::active();
+  double t_min, t_max;
+
+  if (extent == SegmentExtent::Trimmed) {
+    workspace_->projections_.resize(N_);
+    double* t = workspace_->projections_.data();
+
+    double bounds[2];
+    sum = table.projectOntoLine(x, y, N_, A, B, C, dir_x, dir_y, t, bounds);
+
+    size_t k = static_cast<size_t>(trim * (N_ - 1));
+    std::nth_element(t, t + k, t + N_);
+    t_min = t[k];
+    std::nth_element(t + k, t + N_ - 1 - k, t + N_);
+    t_max = t[N_ - 1 - k];
+
+    // Points falling behind the limits are nearest to the end points
+    for (size_t i = 0; i < N_; ++i) {
+      double below = (t[i] < t_min) ? t_min - t[i] : 0.0;
+      double above = (t[i] > t_max) ? t[i] - t_max : 0.0;
+      sum += below * below + above * above;
+    }
+  }
+  else {
+    double bounds[2];
+    sum = table.projectOntoLine(x, y, N_, A, B, C, dir_x, dir_y, nullptr,
+                                bounds);
+    t_min = bounds[0];
+    t_max = bounds[1];
+  }
+
+  if (!(t_max > t_min))
+    return FitStatus::Degenerate;
+
+  Point foot(-A * C, -B * C);
+  Vec dir(dir_x, dir_y);
+
+  s = Segment(foot + t_min * dir, foot + t_max * dir);
+
+  return FitStatus::Ok;
+}
+
+void FigureFitter::fitCircle(Circle& c) {
+  check(tryFitCircle(c), "circle");
+}
+
+void FigureFitter::fitCircle(Circle& c, double& variance) {
+  check(tryFitCircle(c, variance), "circle");
+}
+
+FitStatus FigureFitter::tryFitCircle(Circle& c) {
+  return tryFitCircle(findCubicMoments(), c);
+}
+
+FitStatus FigureFitter::tryFitCircle(Circle& c, double& variance) {
+  FitStatus status = tryFitCircle(c);
+  if (status == FitStatus::Ok)
+    variance = findVarianceAboutCircle(c);
+
+  return status;
+}
+
+void FigureFitter::fitCircleOfRadius(Circle& c, double radius) {
+  check(tryFitCircleOfRadius(c, radius), "circle");
+}
+
+void FigureFitter::fitCircleOfRadius(Circle& c, double radius,
+                                     double& variance) {
+  check(tryFitCircleOfRadius(c, radius, variance), "circle");
+}
+
+FitStatus FigureFitter::tryFitCircleOfRadius(Circle& c, double radius) {
+  if (N_ < 2)
+    return FitStatus::TooFewPoints;
+
+  radius = std::abs(radius);
+
+  CubicMoments m = findCubicMoments();
+  double mean_x = m.mean_x, mean_y = m.mean_y;
+  double s_uu = m.s_xx, s_uv = m.s_xy, s_vv = m.s_yy;
+  double s_uuu = m.s_xxx, s_uuv = m.s_xxy, s_uvv = m.s_xyy, s_vvv = m.s_yyy;
+
+  // Algebraic fit in centered coordinates reduces to the 2x2 system
+  // [s_uu s_uv; s_uv s_vv] * [a; b] = [s_uuu + s_uvv; s_uuv + s_vvv] / 2
+  double det = s_uu * s_vv - s_uv * s_uv;
+  double dir_x, dir_y;
+  if (det > 1e-12 * (s_uu + s_vv) * (s_uu + s_vv)) {
+    dir_x = 0.5 * ( s_vv * (s_uuu + s_uvv) - s_uv * (s_uuv + s_vvv)) / det;
+    dir_y = 0.5 * (-s_uv * (s_uuu + s_uvv) + s_uu * (s_uuv + s_vvv)) / det;
+  }
+  else {
+    // Points are collinear: use the normal of their principal axis
+    double theta = 0.5 * atan2(2.0 * s_uv, s_uu - s_vv);
+    dir_x = -sin(theta);
+    dir_y = cos(theta);
+    if (dir_x * mean_x + dir_y * mean_y < 0.0) {
+      dir_x = -dir_x;
+      dir_y = -dir_y;
+    }
+  }
+
+  double dir_length = sqrt(dir_x * dir_x + dir_y * dir_y);
+  double offset_squared = radius * radius - (s_uu + s_vv) / N_;
+  double offset = (offset_squared > 0.0) ? sqrt(offset_squared) : 0.0;
+
+  Point center(mean_x, mean_y);
+  if (dir_length > 0.0)
+    center += (offset / dir_length) * Vec(dir_x, dir_y);
+
+  refineCenter(center, radius, std::numeric_limits<double>::infinity());
+
+  c = Circle(center, radius);
+
+  return FitStatus::Ok;
+}
+
+FitStatus FigureFitter::tryFitCircleOfRadius(Circle& c, double radius,
+                                             double& variance) {
+  FitStatus status = tryFitCircleOfRadius(c, radius);
+  if (status == FitStatus::Ok)
+    variance = findVarianceAboutCircle(c);
+
+  return status;
+}
+
+void FigureFitter::fitCircleOfRadiusRobust(Circle& c, double radius,
+                                           double threshold,
+                                           size_t hypotheses) {
+  check(tryFitCircleOfRadiusRobust(c, radius, threshold, hypotheses),
+        "circle");
+}
+
+void FigureFitter::fitCircleOfRadiusRobust(Circle& c, double radius,
+                                           double threshold, double& variance,
+                                           size_t hypotheses) {
+  check(tryFitCircleOfRadiusRobust(c, radius, threshold, variance,
+                                   hypotheses), "circle");
+}
+
+FitStatus FigureFitter::tryFitCircleOfRadiusRobust(Circle& c, double radius,
+                                                   double threshold,
+                                                   size_t hypotheses) {
+  double variance;
+  return tryFitCircleOfRadiusRobust(c, radius, threshold, variance,
+                                    hypotheses);
+}
+
+FitStatus FigureFitter::tryFitCircleOfRadiusRobust(Circle& c, double radius,
+                                                   double threshold,
+                                                   double& variance,
+                                                   size_t hypotheses) {
+  if (N_ < 2)
+    return FitStatus::TooFewPoints;
+
+  radius = std::abs(radius);
+  threshold = std::abs(threshold);
+
+  const double* x = x_coords_.memptr();
+  const double* y = y_coords_.memptr();
+
+  // Inlier band on squared distance from the center
+  double inner = std::max(radius - threshold, 0.0);
+  double lower = inner * inner;
+  double upper = (radius + threshold) * (radius + threshold);
+
+  const auto count_in_annulus = kernels::active().countInAnnulus;
+
+  std::minstd_rand random_engine;
+  std::uniform_int_distribution<size_t> distribution(0, N_ - 1);
+
+  Point best_center;
+  size_t best_inliers = 0;
+
+  for (size_t h = 0; h < hypotheses; ++h) {
+    size_t i = distribution(random_engine);
+    size_t j = distribution(random_engine);
+
+    // Centers lie on the bisector of the chord, at distance sqrt(r^2 - l^2/4)
+    Vec chord(x[j] - x[i], y[j] - y[i]);
+    double chord_squared = chord.lengthSquared();
+    double height_squared = radius * radius - chord_squared / 4.0;
+    if (chord_squared == 0.0 || height_squared < 0.0)
+      continue;
+
+    Point mid((x[i] + x[j]) / 2.0, (y[i] + y[j]) / 2.0);
+    Vec height = sqrt(height_squared / chord_squared) * chord.rotated90();
+
+    for (const Vec& center : {mid + height, mid - height}) {
+      size_t inliers = count_in_annulus(x, y, N_, center.x, center.y,
+                                        lower, upper);
+
+      if (inliers > best_inliers) {
+        best_inliers = inliers;
+        best_center = center;
+      }
+    }
+  }
+
+  if (best_inliers == 0)
+    return FitStatus::NoSolution;
+
+  std::pair<double, size_t> result = refineCenter(best_center, radius,
+                                                  threshold);
+
+  c = Circle(best_center, radius);
+  variance = (result.second > 0) ? result.first / result.second : 0.0;
+
+  return FitStatus::Ok;
+}
+
+void FigureFitter::fitEllipse(Ellipse& e) {
+  check(tryFitEllipse(e), "ellipse");
+}
+
+void FigureFitter::fitEllipse(Ellipse& e, double& variance) {
+  check(tryFitEllipse(e, variance), "ellipse");
+}
+
+FitStatus FigureFitter::tryFitEllipse(Ellipse& e) {
+  if (N_ < 5)
+    return FitStatus::TooFewPoints;
+
+  Moments m = findMoments();
+  double scale = sqrt((m.s_xx + m.s_yy) / (2.0 * N_));
+  if (scale == 0.0)
+    return FitStatus::Degenerate;
+
+  const double* x = x_coords_.memptr();
+  const double* y = y_coords_.memptr();
+
+  // Sums of monomials u^i v^j of centered and scaled coordinates. The first
+  // order sums vanish due to centering.
+  double s_40 = 0.0, s_31 = 0.0, s_22 = 0.0, s_13 = 0.0, s_04 = 0.0;
+  double s_30 = 0.0, s_21 = 0.0, s_12 = 0.0, s_03 = 0.0;
+  double s_20 = 0.0, s_11 = 0.0, s_02 = 0.0;
+  for (size_t i = 0; i < N_; ++i) {
+    double u = (x[i] - m.mean_x) / scale;
+    double v = (y[i] - m.mean_y) / scale;
+    double uu = u * u, uv = u * v, vv = v * v;
+
+    s_40 += uu * uu;
+    s_31 += uu * uv;
+    s_22 += uu * vv;
+    s_13 += uv * vv;
+    s_04 += vv * vv;
+    s_30 += uu * u;
+    s_21 += uu * v;
+    s_12 += u * vv;
+    s_03 += vv * v;
+    s_20 += uu;
+    s_11 += uv;
+    s_02 += vv;
+  }
+
+  // Quadratic block S1, mixed block S2 and linear block S3 of the scatter
+  const double s1[3][3] = {{s_40, s_31, s_22},
+                           {s_31, s_22, s_13},
+                           {s_22, s_13, s_04}};
+  const double s2[3][3] = {{s_30, s_21, s_20},
+                           {s_21, s_12, s_11},
+                           {s_12, s_03, s_02}};
+  const double n = static_cast<double>(N_);
+
+  // S3 = [s_20 s_11 0; s_11 s_02 0; 0 0 n], hence its inverse is block-wise
+  double det = s_20 * s_02 - s_11 * s_11;
+  if (det <= 0.0)
+    return FitStatus::Collinear;
+
+  const double s3_inv[3][3] = {{ s_02 / det, -s_11 / det, 0.0},
+                               {-s_11 / det,  s_20 / det, 0.0},
+                               {0.0, 0.0, 1.0 / n}};
+
+  // T = -S3^-1 * S2^T
+  double t[3][3];
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j) {
+      t[i][j] = 0.0;
+      for (int k = 0; k < 3; ++k)
+        t[i][j] -= s3_inv[i][k] * s2[j][k];
+    }
+
+  // M = S1 + S2 * T
+  double m_reduced[3][3];
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j) {
+      m_reduced[i][j] = s1[i][j];
+      for (int k = 0; k < 3; ++k)
+        m_reduced[i][j] += s2[i][k] * t[k][j];
+    }
+
+  // M = C1^-1 * M, where C1 = [0 0 2; 0 -1 0; 2 0 0]
+  double m_constrained[3][3];
+  for (int j = 0; j < 3; ++j) {
+    m_constrained[0][j] = m_reduced[2][j] / 2.0;
+    m_constrained[1][j] = -m_reduced[1][j];
+    m_constrained[2][j] = m_reduced[0][j] / 2.0;
+  }
+
+  double a1[3];
+  if (!findEllipticEigenvector(m_constrained, a1))
+    return FitStatus::NoSolution;
+
+  double a2[3];
+  for (int i = 0; i < 3; ++i)
+    a2[i] = t[i][0] * a1[0] + t[i][1] * a1[1] + t[i][2] * a1[2];
+
+  // Conic A u^2 + B uv + C v^2 + D u + E v + F = 0 with A + C > 0
+  double sign = (a1[0] + a1[2] >= 0.0) ? 1.0 : -1.0;
+  double A = sign * a1[0], B = sign * a1[1], C = sign * a1[2];
+  double D = sign * a2[0], E = sign * a2[1], F = sign * a2[2];
+
+  double denominator = 4.0 * A * C - B * B;
+  double u0 = (B * E - 2.0 * C * D) / denominator;
+  double v0 = (B * D - 2.0 * A * E) / denominator;
+  double f0 = F + (D * u0 + E * v0) / 2.0;
+
+  // Quadratic form along direction theta and perpendicular to it
+  double theta = 0.5 * atan2(B, A - C);
+  double c = cos(theta);
+  double s = sin(theta);
+  double q1 = A * c * c + B * c * s + C * s * s;
+  double q2 = A * s * s - B * c * s + C * c * c;
+
+  if (f0 >= 0.0 || q1 <= 0.0 || q2 <= 0.0)
+    return FitStatus::NoSolution;
+
+  Point center(m.mean_x + scale * u0, m.mean_y + scale * v0);
+  e = Ellipse(center, scale * sqrt(-f0 / q1), scale * sqrt(-f0 / q2), theta);
+
+  return FitStatus::Ok;
+}
+
+FitStatus FigureFitter::tryFitEllipse(Ellipse& e, double& variance) {
+  FitStatus status = tryFitEllipse(e);
+  if (status == FitStatus::Ok)
+    variance = findVarianceAbout(e);
+
+  return status;
+}
+
+void FigureFitter::fitRectangle(Rectangle& r) {
+  check(tryFitRectangle(r), "rectangle");
+}
+
+void FigureFitter::fitRectangle(Rectangle& r, double& variance) {
+  check(tryFitRectangle(r, variance), "rectangle");
+}
+
+FitStatus FigureFitter::tryFitRectangle(Rectangle& r) {
+  if (N_ < 3)
+    return FitStatus::TooFewPoints;
+
+  const int coarse_steps = 18;
+  const int refinement_levels = 3;
+
+  double bounds[4];
+  double step = M_PI / 2.0 / coarse_steps;
+  double best_theta = 0.0;
+  double best_cost = std::numeric_limits<double>::infinity();
+
+  for (int i = 0; i < coarse_steps; ++i) {
+    double cost = findRectangleCost(i * step, bounds);
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_theta = i * step;
+    }
+  }
+
+  for (int level = 0; level < refinement_levels; ++level) {
+    double center = best_theta;
+    step /= 4.0;
+
+    for (int i = -3; i <= 3; ++i) {
+      if (i == 0)
+        continue;
+
+      double theta = center + i * step;
+      double cost = findRectangleCost(theta, bounds);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_theta = theta;
+      }
+    }
+  }
+
+  findRectangleCost(best_theta, bounds);
+
+  Vec e1(cos(best_theta), sin(best_theta));
+  Vec e2 = e1.rotated90();
+  Point center = (bounds[0] + bounds[1]) / 2.0 * e1 +
+                 (bounds[2] + bounds[3]) / 2.0 * e2;
+
+  r = Rectangle(center, bounds[1] - bounds[0], bounds[3] - bounds[2],
+                best_theta);
+
+  return FitStatus::Ok;
+}
+
+FitStatus FigureFitter::tryFitRectangle(Rectangle& r, double& variance) {
+  FitStatus status = tryFitRectangle(r);
+  if (status == FitStatus::Ok)
+    variance = findVarianceAbout(r);
+
+  return status;
+}
+
+double FigureFitter::findRectangleCost(double theta, double bounds[4]) const {
+  const double* x = x_coords_.memptr();
+  const double* y = y_coords_.memptr();
+
+  double c = cos(theta);
+  double s = sin(theta);
+
+  double min_1 = std::numeric_limits<double>::infinity();
+  double max_1 = -std::numeric_limits<double>::infinity();
+  double min_2 = std::numeric_limits<double>::infinity();
+  double max_2 = -std::numeric_limits<double>::infinity();
+
+  for (size_t i = 0; i < N_; ++i) {
+    double c_1 = c * x[i] + s * y[i];
+    double c_2 = -s * x[i] + c * y[i];
+    min_1 = (c_1 < min_1) ? c_1 : min_1;
+    max_1 = (c_1 > max_1) ? c_1 : max_1;
+    min_2 = (c_2 < min_2) ? c_2 : min_2;
+    max_2 = (c_2 > max_2) ? c_2 : max_2;
+  }
+
+  double cost = 0.0;
+  for (size_t i = 0; i < N_; ++i) {
+    double c_1 = c * x[i] + s * y[i];
+    double c_2 = -s * x[i] + c * y[i];
+    double d_1 = std::min(max_1 - c_1, c_1 - min_1);
+    double d_2 = std::min(max_2 - c_2, c_2 - min_2);
+    double d = std::min(d_1, d_2);
+    cost += d * d;
+  }
+
+  bounds[0] = min_1;
+  bounds[1] = max_1;
+  bounds[2] = min_2;
+  bounds[3] = max_2;
+
+  return cost;
+}
+
+void FigureFitter::fitPerpendicularLines(const FigureFitter& first,
+                                         const FigureFitter& second,
+                                         Line& l1, Line& l2) {
+  check(tryFitPerpendicularLines(first, second, l1, l2), "lines", true);
+}
+
+void FigureFitter::fitPerpendicularLines(const FigureFitter& first,
+                                         const FigureFitter& second,
+                                         Line& l1, Line& l2,
+                                         double& variance1,
+                                         double& variance2) {
+  check(tryFitPerpendicularLines(first, second, l1, l2, variance1, variance2),
+        "lines", true);
+}
+
+FitStatus FigureFitter::tryFitPerpendicularLines(const FigureFitter& first,
+                                                 const FigureFitter& second,
+                                                 Line& l1, Line& l2) {
+  double variance1, variance2;
+  return tryFitPerpendicularLines(first, second, l1, l2, variance1,
+                                  variance2);
+}
+
+FitStatus FigureFitter::tryFitPerpendicularLines(const FigureFitter& first,
+                                                 const FigureFitter& second,
+                                                 Line& l1, Line& l2,
+                                                 double& variance1,
+                                                 double& variance2) {
+  if (first.N_ < 1 || second.N_ < 1)
+    return FitStatus::TooFewPoints;
+
+  const Moments m1 = first.findMoments();
+  const Moments m2 = second.findMoments();
+
+  Moments joint;
+  addOnAxis(m1, 0, joint);
+  addOnAxis(m2, 1, joint);
+
+  Vec direction;
+  FitStatus status = findJointDirection(joint, direction);
+  if (status != FitStatus::Ok)
+    return status;
+
+  l1 = findLineAlong(m1, direction, variance1);
+  l2 = findLineAlong(m2, direction.rotated90(), variance2);
+
+  return FitStatus::Ok;
+}
+
+void FigureFitter::fitLine(const Moments& m, Line& l) {
+  check(tryFitLine(m, l), "line", true);
+}
+
+void FigureFitter::fitLine(const Moments& m, Line& l, double& variance) {
+  check(tryFitLine(m, l, variance), "line", true);
+}
+
+FitStatus FigureFitter::tryFitLine(const Moments& m, Line& l) {
+  if (m.n < 2)
+    return FitStatus::TooFewPoints;
+
+  // Cramer's rule for [sum x^2, sum xy; sum xy, sum y^2] [A; B] = [sum x;
+  // sum y] with the raw sums expanded about the centroid
+  double n = m.n;
+  double det = m.s_xx * m.s_yy - m.s_xy * m.s_xy +
+               n * (m.mean_x * m.mean_x * m.s_yy +
+                    m.mean_y * m.mean_y * m.s_xx -
+                    2.0 * m.mean_x * m.mean_y * m.s_xy);
+
+  double A = (m.s_yy * m.mean_x - m.s_xy * m.mean_y) * n;
+  double B = (m.s_xx * m.mean_y - m.s_xy * m.mean_x) * n;
+
+  // Rank tolerance of the pseudo inverse, i.e. the smaller singular value of
+  // [x y] below max(n, 2) * eps times the larger one
+  double g_xx = m.s_xx + n * m.mean_x * m.mean_x;
+  double g_xy = m.s_xy + n * m.mean_x * m.mean_y;
+  double g_yy = m.s_yy + n * m.mean_y * m.mean_y;
+  double trace = g_xx + g_yy;
+  double tolerance = std::max(n, 2.0) *
+                     std::numeric_limits<double>::epsilon() * trace;
+
+  if (!(det > tolerance * tolerance)) {
+    // Rank one, e.g. identical points: the pseudo inverse of the normal
+    // matrix G is G / trace^2
+    if (!(trace > 0.0))
+      return FitStatus::NoSolution;
+
+    det = trace * trace;
+    A = (g_xx * m.mean_x + g_xy * m.mean_y) * n;
+    B = (g_xy * m.mean_x + g_yy * m.mean_y) * n;
+  }
+
+  if (A == 0.0 && B == 0.0)
+    return FitStatus::NoSolution;
+
+  l = Line(A / det, B / det, -1.0);
+
+  return FitStatus::Ok;
+}
+
+FitStatus FigureFitter::tryFitLine(const Moments& m, Line& l,
+                                   double& variance) {
+  FitStatus status = tryFitLine(m, l);
+  if (status == FitStatus::Ok) {
+    double offset = l.A() * m.mean_x + l.B() * m.mean_y + l.C();
+    variance = m.residualAlong(l.A(), l.B()) / m.n + offset * offset;
+  }
+
+  return status;
+}
+
+void FigureFitter::fitCircle(const CubicMoments& m, Circle& c) {
+  check(tryFitCircle(m, c), "circle");
+}
+
+FitStatus FigureFitter::tryFitCircle(const CubicMoments& m, Circle& c) {
+  if (m.n < 3)
+    return FitStatus::TooFewPoints;
+
+  double det = m.s_xx * m.s_yy - m.s_xy * m.s_xy;
+  if (!(det > 0.0))
+    return FitStatus::Collinear;
+
+  double r_x = (m.s_xxx + m.s_xyy) / 2.0;
+  double r_y = (m.s_xxy + m.s_yyy) / 2.0;
+
+  double a = (m.s_yy * r_x - m.s_xy * r_y) / det;
+  double b = (m.s_xx * r_y - m.s_xy * r_x) / det;
+
+  Point center(m.mean_x + a, m.mean_y + b);
+  double radius = sqrt(a * a + b * b + (m.s_xx + m.s_yy) / m.n);
+
+  c = Circle(center, radius);
+
+  return FitStatus::Ok;
+}
+
+Moments FigureFitter::findMoments() const {
+  if (cache_ == Cache::None) {
+    moments_ = CubicMoments();
+    moments_.Moments::addBlock(x_coords_.memptr(), y_coords_.memptr(), N_);
+    cache_ = Cache::Moments;
+  }
+
+  return moments_;
+}
+
+CubicMoments FigureFitter::findCubicMoments() const {
+  if (cache_ != Cache::Cubic) {
+    moments_ = CubicMoments();
+    moments_.addBlock(x_coords_.memptr(), y_coords_.memptr(), N_);
+    cache_ = Cache::Cubic;
+  }
+
+  return moments_;
+}
+
+double FigureFitter::findGridAngle(const std::vector<Moments>& moments) {
+  // Principal angles have period pi, grid angle has period pi/2
+  double sum_sin = 0.0;
+  double sum_cos = 0.0;
+  for (const Moments& m : moments) {
+    double phi = m.principalAngle();
+    sum_sin += m.anisotropy() * sin(4.0 * phi);
+    sum_cos += m.anisotropy() * cos(4.0 * phi);
+  }
+
+  return 0.25 * atan2(sum_sin, sum_cos);
+}
+
+int FigureFitter::findGridAxis(const Moments& m, double grid_angle) {
+  return (cos(2.0 * (m.principalAngle() - grid_angle)) >= 0.0) ? 0 : 1;
+}
+
+void FigureFitter::addOnAxis(const Moments& m, int axis, Moments& joint) {
+  // Joint scatter with axis 1 sets rotated by 90 deg: [a b; b c] -> [c -b; -b a]
+  if (axis == 0) {
+    joint.s_xx += m.s_xx;
+    joint.s_xy += m.s_xy;
+    joint.s_yy += m.s_yy;
+  }
+  else {
+    joint.s_xx += m.s_yy;
+    joint.s_xy -= m.s_xy;
+    joint.s_yy += m.s_xx;
+  }
+}
+
+FitStatus FigureFitter::findJointDirection(const Moments& joint,
+                                           Vec& direction) {
+  // Isotropic scatter, principalAngle() would be atan2(0, 0)
+  if (joint.anisotropy() == 0.0)
+    return FitStatus::Degenerate;
+
+  double theta = joint.principalAngle();
+  direction = Vec(cos(theta), sin(theta));
+
+  return FitStatus::Ok;
+}
+
+Line FigureFitter::findLineAlong(const Moments& m, const Vec& d,
+                                 double& variance) {
+  // Normal (A, B) = (-d_y, d_x), line passes through the centroid
+  double A = -d.y;
+  double B = d.x;
+  double C = -(A * m.mean_x + B * m.mean_y);
+
+  variance = m.residualAlong(A, B) / m.n;
+  return Line(A, B, C);
+}
+
+void FigureFitter::check(FitStatus status, const char* figure,
+                         bool too_few_is_logic_error,
+                         bool degenerate_is_logic_error) {
+  if (status == FitStatus::Ok)
+    return;
+
+  std::string message = std::string("Error while fitting ") + figure + ": " +
+                        toString(status) + ".";
+
+  if (status == FitStatus::InvalidArgument ||
+      (status == FitStatus::TooFewPoints && too_few_is_logic_error) ||
+      (status == FitStatus::Degenerate && degenerate_is_logic_error))
+    throw std::logic_error(message);
+  else
+    throw std::runtime_error(message);
+}
+
+bool FigureFitter::findEllipticEigenvector(const double m[3][3], double v[3]) {
+  // Characteristic polynomial lambda^3 + b * lambda^2 + c * lambda + d
+  double b = -(m[0][0] + m[1][1] + m[2][2]);
+  double c = m[0][0] * m[1][1] - m[0][1] * m[1][0] +
+             m[0][0] * m[2][2] - m[0][2] * m[2][0] +
+             m[1][1] * m[2][2] - m[1][2] * m[2][1];
+  double d = -(m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+               m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+               m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]));
+
+  // Depressed cubic t^3 + p * t + q with lambda = t - b / 3
+  double p = c - b * b / 3.0;
+  double q = 2.0 * b * b * b / 27.0 - b * c / 3.0 + d;
+  double discriminant = q * q / 4.0 + p * p * p / 27.0;
+
+  double roots[3];
+  int n_roots;
+  if (discriminant > 0.0) {
+    double sqrt_d = sqrt(discriminant);
+    roots[0] = cbrt(-q / 2.0 + sqrt_d) + cbrt(-q / 2.0 - sqrt_d) - b / 3.0;
+    n_roots = 1;
+  }
+  else {
+    double r = (p < 0.0) ? 2.0 * sqrt(-p / 3.0) : 0.0;
+    double phi = (r > 0.0) ?
+          acos(std::max(-1.0, std::min(1.0, 3.0 * q / (p * r)))) / 3.0 : 0.0;
+    for (int k = 0; k < 3; ++k)
+      roots[k] = r * cos(phi - 2.0 * M_PI * k / 3.0) - b / 3.0;
+    n_roots = 3;
+  }
+
+  double best_constraint = 0.0;
+  bool found = false;
+
+  for (int k = 0; k < n_roots; ++k) {
+    double r[3][3];
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        r[i][j] = m[i][j] - (i == j ? roots[k] : 0.0);
+
+    // Eigenvector is orthogonal to all rows of (m - lambda * I)
+    double best_norm = 0.0;
+    double w[3] = {0.0, 0.0, 0.0};
+    for (int i = 0; i < 3; ++i) {
+      const double* r1 = r[i];
+      const double* r2 = r[(i + 1) % 3];
+      double cross[3] = {r1[1] * r2[2] - r1[2] * r2[1],
+                         r1[2] * r2[0] - r1[0] * r2[2],
+                         r1[0] * r2[1] - r1[1] * r2[0]};
+      double norm = cross[0] * cross[0] + cross[1] * cross[1] +
+                    cross[2] * cross[2];
+      if (norm > best_norm) {
+        best_norm = norm;
+        w[0] = cross[0];
+        w[1] = cross[1];
+        w[2] = cross[2];
+      }
+    }
+
+    if (best_norm == 0.0)
+      continue;
+
+    double scale = 1.0 / sqrt(best_norm);
+    double constraint = (4.0 * w[0] * w[2] - w[1] * w[1]) * scale * scale;
+    if (constraint > best_constraint) {
+      best_constraint = constraint;
+      v[0] = w[0] * scale;
+      v[1] = w[1] * scale;
+      v[2] = w[2] * scale;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+std::pair<double, size_t> FigureFitter::refineCenter(Point& center,
+                                                     double radius,
+                                                     double threshold) const {
+  const int max_steps = 3;
+
+  const auto center_step = kernels::active().circleCenterStep;
+
+  double sums[6] = {};
+  size_t count = 0;
+
+  for (int step = 0; step <= max_steps; ++step) {
+    count = center_step(x_coords_.memptr(), y_coords_.memptr(), N_,
+                        center.x, center.y, radius, threshold, sums);
+
+    double j_xx = sums[0], j_xy = sums[1], j_yy = sums[2];
+    double g_x = sums[3], g_y = sums[4];
+
+    // The last pass only evaluates the residuals
+    double det = j_xx * j_yy - j_xy * j_xy;
+    if (step == max_steps || det <= 0.0)
+      break;
+
+    double delta_x = ( j_yy * g_x - j_xy * g_y) / det;
+    double delta_y = (-j_xy * g_x + j_xx * g_y) / det;
+    center += Vec(delta_x, delta_y);
+
+    if (delta_x * delta_x + delta_y * delta_y < 1e-24 * radius * radius)
+      break;
+  }
+
+  return std::make_pair(sums[5], count);
+}
+
+} // end namespace figfit
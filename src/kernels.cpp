@@ -0,0 +1,93 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "../kernels.h"
+
+namespace figfit
+{
+
+namespace kernels
+{
+
+namespace baseline { extern const KernelTable table; }
+
+#ifdef FIGFIT_X86_DISPATCH
+namespace avx2 { extern const KernelTable table; }
+namespace avx512 { extern const KernelTable table; }
+#endif
+
+namespace
+{
+
+/*
+ * Check if the processor supports given level
+ */
+bool isSupported(Isa isa) {
+#ifdef FIGFIT_X86_DISPATCH
+  __builtin_cpu_init();
+  switch (isa) {
+    case Isa::Baseline: return true;
+    case Isa::AVX2: return __builtin_cpu_supports("avx2");
+    case Isa::AVX512: return __builtin_cpu_supports("avx512f");
+  }
+  return false;
+#else
+  return isa == Isa::Baseline;
+#endif
+}
+
+/*
+ * Select the best supported level not above the one given by FIGFIT_ISA
+ */
+const KernelTable& select() {
+  Isa limit = Isa::AVX512;
+
+  if (const char* name = std::getenv("FIGFIT_ISA")) {
+    if (std::strcmp(name, "baseline") == 0)
+      limit = Isa::Baseline;
+    else if (std::strcmp(name, "avx2") == 0)
+      limit = Isa::AVX2;
+  }
+
+  const KernelTable* table = nullptr;
+  if (limit >= Isa::AVX512)
+    table = find(Isa::AVX512);
+  if (!table && limit >= Isa::AVX2)
+    table = find(Isa::AVX2);
+
+  return table ? *table : baseline::table;
+}
+
+} // end anonymous namespace
+
+const KernelTable& active() {
+  static const KernelTable& table = select();
+  return table;
+}
+
+const KernelTable* find(Isa isa) {
+  if (!isSupported(isa))
+    return nullptr;
+
+  switch (isa) {
+    case Isa::Baseline: return &baseline::table;
+#ifdef FIGFIT_X86_DISPATCH
+    case Isa::AVX2: return &avx2::table;
+    case Isa::AVX512: return &avx512::table;
+#endif
+    default: return nullptr;
+  }
+}
+
+const char* toString(Isa isa) {
+  switch (isa) {
+    case Isa::Baseline: return "baseline";
+    case Isa::AVX2: return "avx2";
+    case Isa::AVX512: return "avx512";
+  }
+  return "unknown";
+}
+
+} // end namespace kernels
+
+} // end namespace figfit
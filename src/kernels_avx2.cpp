@@ -0,0 +1,8 @@
+#ifndef __AVX2__
+#error "kernels_avx2.cpp must be compiled with -mavx2"
+#endif
+
+#define FIGFIT_KERNEL_ISA avx2
+#define FIGFIT_KERNEL_ISA_ENUM Isa::AVX2
+
+#include "kernels_impl.h"
@@ -0,0 +1,8 @@
+#ifndef __AVX512F__
+#error "kernels_avx512.cpp must be compiled with -mavx512f"
+#endif
+
+#define FIGFIT_KERNEL_ISA avx512
+#define FIGFIT_KERNEL_ISA_ENUM Isa::AVX512
+
+#include "kernels_impl.h"
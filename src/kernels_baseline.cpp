@@ -0,0 +1,4 @@
+#define FIGFIT_KERNEL_ISA baseline
+#define FIGFIT_KERNEL_ISA_ENUM Isa::Baseline
+
+#include "kernels_impl.h"
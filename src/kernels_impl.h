@@ -0,0 +1,392 @@
+#pragma once
+
+#include "../kernels.h"
+
+/*
+ * Kernel source compiled once per instruction set level. The including file
+ * defines FIGFIT_KERNEL_ISA (the name of the namespace of the table) and
+ * FIGFIT_KERNEL_ISA_ENUM, and is compiled with the flags of its level.
+ *
+ * The loops are written over blocks of a fixed number of lanes with separate
+ * accumulators, which the compiler vectorizes with any vector width without
+ * reassociating floating point operations. The lanes are combined in a fixed
+ * order and the remainder is processed one point at a time, so that the
+ * results do not depend on the level.
+ *
+ * Everything but the table has internal linkage and no headers with inline
+ * functions are included: an inline function compiled here with e.g. AVX-512
+ * enabled could otherwise be picked by the linker for the whole program.
+ */
+
+#if !defined(FIGFIT_KERNEL_ISA) || !defined(FIGFIT_KERNEL_ISA_ENUM)
+#error "FIGFIT_KERNEL_ISA and FIGFIT_KERNEL_ISA_ENUM must be defined"
+#endif
+
+namespace figfit
+{
+
+namespace kernels
+{
+
+namespace FIGFIT_KERNEL_ISA
+{
+
+namespace
+{
+
+const size_t L = 8;   // Number of lanes (a 512-bit vector of doubles)
+
+/*
+ * Sum of lanes in a fixed order
+ */
+double sumLanes(const double v[L]) {
+  return ((v[0] + v[1]) + (v[2] + v[3])) + ((v[4] + v[5]) + (v[6] + v[7]));
+}
+
+/*
+ * Centroid of a point set
+ */
+void findMean(const double* x, const double* y, size_t n,
+              double& mean_x, double& mean_y) {
+  double s_x[L] = {}, s_y[L] = {};
+  const size_t blocks = n - n % L;
+
+  for (size_t i = 0; i < blocks; i += L)
+    for (size_t j = 0; j < L; ++j) {
+      s_x[j] += x[i + j];
+      s_y[j] += y[i + j];
+    }
+
+  double sum_x = sumLanes(s_x), sum_y = sumLanes(s_y);
+  for (size_t i = blocks; i < n; ++i) {
+    sum_x += x[i];
+    sum_y += y[i];
+  }
+
+  mean_x = sum_x / n;
+  mean_y = sum_y / n;
+}
+
+void moments(const double* x, const double* y, size_t n, double sums[5]) {
+  double mean_x, mean_y;
+  findMean(x, y, n, mean_x, mean_y);
+
+  double s_xx[L] = {}, s_xy[L] = {}, s_yy[L] = {};
+  const size_t blocks = n - n % L;
+
+  for (size_t i = 0; i < blocks; i += L)
+    for (size_t j = 0; j < L; ++j) {
+      double u = x[i + j] - mean_x;
+      double v = y[i + j] - mean_y;
+      s_xx[j] += u * u;
+      s_xy[j] += u * v;
+      s_yy[j] += v * v;
+    }
+
+  double xx = sumLanes(s_xx), xy = sumLanes(s_xy), yy = sumLanes(s_yy);
+  for (size_t i = blocks; i < n; ++i) {
+    double u = x[i] - mean_x;
+    double v = y[i] - mean_y;
+    xx += u * u;
+    xy += u * v;
+    yy += v * v;
+  }
+
+  sums[0] = mean_x;
+  sums[1] = mean_y;
+  sums[2] = xx;
+  sums[3] = xy;
+  sums[4] = yy;
+}
+
+void cubicMoments(const double* x, const double* y, size_t n,
+                  double sums[9]) {
+  double mean_x, mean_y;
+  findMean(x, y, n, mean_x, mean_y);
+
+  double s_xx[L] = {}, s_xy[L] = {}, s_yy[L] = {};
+  double s_xxx[L] = {}, s_xxy[L] = {}, s_xyy[L] = {}, s_yyy[L] = {};
+  const size_t blocks = n - n % L;
+
+  for (size_t i = 0; i < blocks; i += L)
+    for (size_t j = 0; j < L; ++j) {
+      double u = x[i + j] - mean_x;
+      double v = y[i + j] - mean_y;
+      double uu = u * u, uv = u * v, vv = v * v;
+      s_xx[j] += uu;
+      s_xy[j] += uv;
+      s_yy[j] += vv;
+      s_xxx[j] += uu * u;
+      s_xxy[j] += uu * v;
+      s_xyy[j] += uv * v;
+      s_yyy[j] += vv * v;
+    }
+
+  double xx = sumLanes(s_xx), xy = sumLanes(s_xy), yy = sumLanes(s_yy);
+  double xxx = sumLanes(s_xxx), xxy = sumLanes(s_xxy);
+  double xyy = sumLanes(s_xyy), yyy = sumLanes(s_yyy);
+  for (size_t i = blocks; i < n; ++i) {
+    double u = x[i] - mean_x;
+    double v = y[i] - mean_y;
+    double uu = u * u, uv = u * v, vv = v * v;
+    xx += uu;
+    xy += uv;
+    yy += vv;
+    xxx += uu * u;
+    xxy += uu * v;
+    xyy += uv * v;
+    yyy += vv * v;
+  }
+
+  sums[0] = mean_x;
+  sums[1] = mean_y;
+  sums[2] = xx;
+  sums[3] = xy;
+  sums[4] = yy;
+  sums[5] = xxx;
+  sums[6] = xxy;
+  sums[7] = xyy;
+  sums[8] = yyy;
+}
+
+double lineDistanceSquared(const double* x, const double* y, size_t n,
+                           double A, double B, double C) {
+  double s[L] = {};
+  const size_t blocks = n - n % L;
+
+  for (size_t i = 0; i < blocks; i += L)
+    for (size_t j = 0; j < L; ++j) {
+      double d = A * x[i + j] + B * y[i + j] + C;
+      s[j] += d * d;
+    }
+
+  double sum = sumLanes(s);
+  for (size_t i = blocks; i < n; ++i) {
+    double d = A * x[i] + B * y[i] + C;
+    sum += d * d;
+  }
+
+  return sum;
+}
+
+double circleDistanceSquared(const double* x, const double* y, size_t n,
+                             double center_x, double center_y,
+                             double radius) {
+  double s[L] = {};
+  const size_t blocks = n - n % L;
+
+  for (size_t i = 0; i < blocks; i += L)
+    for (size_t j = 0; j < L; ++j) {
+      double u = x[i + j] - center_x;
+      double v = y[i + j] - center_y;
+      double d = __builtin_sqrt(u * u + v * v) - radius;
+      s[j] += d * d;
+    }
+
+  double sum = sumLanes(s);
+  for (size_t i = blocks; i < n; ++i) {
+    double u = x[i] - center_x;
+    double v = y[i] - center_y;
+    double d = __builtin_sqrt(u * u + v * v) - radius;
+    sum += d * d;
+  }
+
+  return sum;
+}
+
+size_t countInAnnulus(const double* x, const double* y, size_t n,
+                      double center_x, double center_y,
+                      double lower, double upper) {
+  size_t c[L] = {};
+  const size_t blocks = n - n % L;
+
+  for (size_t i = 0; i < blocks; i += L)
+    for (size_t j = 0; j < L; ++j) {
+      double u = x[i + j] - center_x;
+      double v = y[i + j] - center_y;
+      double d = u * u + v * v;
+      c[j] += (d >= lower && d <= upper) ? 1 : 0;
+    }
+
+  size_t count = 0;
+  for (size_t j = 0; j < L; ++j)
+    count += c[j];
+
+  for (size_t i = blocks; i < n; ++i) {
+    double u = x[i] - center_x;
+    double v = y[i] - center_y;
+    double d = u * u + v * v;
+    count += (d >= lower && d <= upper) ? 1 : 0;
+  }
+
+  return count;
+}
+
+size_t circleCenterStep(const double* x, const double* y, size_t n,
+                        double center_x, double center_y, double radius,
+                        double threshold, double sums[6]) {
+  double s_xx[L] = {}, s_xy[L] = {}, s_yy[L] = {};
+  double s_xr[L] = {}, s_yr[L] = {}, s_rr[L] = {};
+  size_t c[L] = {};
+  const size_t blocks = n - n % L;
+
+  // Points left out get zero weight, which keeps the loop free of branches
+  for (size_t i = 0; i < blocks; i += L)
+    for (size_t j = 0; j < L; ++j) {
+      double u = x[i + j] - center_x;
+      double v = y[i + j] - center_y;
+      double rho = __builtin_sqrt(u * u + v * v);
+      double r = rho - radius;
+      bool in = (rho != 0.0 && __builtin_fabs(r) <= threshold);
+      double rho_in = in ? rho : 1.0;
+      double u_x = (in ? u : 0.0) / rho_in, u_y = (in ? v : 0.0) / rho_in;
+      double r_in = in ? r : 0.0;
+      s_xx[j] += u_x * u_x;
+      s_xy[j] += u_x * u_y;
+      s_yy[j] += u_y * u_y;
+      s_xr[j] += u_x * r_in;
+      s_yr[j] += u_y * r_in;
+      s_rr[j] += r_in * r_in;
+      c[j] += in ? 1 : 0;
+    }
+
+  double xx = sumLanes(s_xx), xy = sumLanes(s_xy), yy = sumLanes(s_yy);
+  double xr = sumLanes(s_xr), yr = sumLanes(s_yr), rr = sumLanes(s_rr);
+  size_t count = 0;
+  for (size_t j = 0; j < L; ++j)
+    count += c[j];
+
+  for (size_t i = blocks; i < n; ++i) {
+    double u = x[i] - center_x;
+    double v = y[i] - center_y;
+    double rho = __builtin_sqrt(u * u + v * v);
+    double r = rho - radius;
+    if (rho == 0.0 || __builtin_fabs(r) > threshold)
+      continue;
+
+    double u_x = u / rho, u_y = v / rho;
+    xx += u_x * u_x;
+    xy += u_x * u_y;
+    yy += u_y * u_y;
+    xr += u_x * r;
+    yr += u_y * r;
+    rr += r * r;
+    count++;
+  }
+
+  sums[0] = xx;
+  sums[1] = xy;
+  sums[2] = yy;
+  sums[3] = xr;
+  sums[4] = yr;
+  sums[5] = rr;
+  return count;
+}
+
+/*
+ * Projection onto line with or without storing the parameters
+ */
+template <bool Store>
+double project(const double* x, const double* y, size_t n,
+               double A, double B, double C, double dir_x, double dir_y,
+               double* t, double bounds[2]) {
+  const double inf = __builtin_inf();
+  double s[L] = {};
+  double lo[L], hi[L];
+  for (size_t j = 0; j < L; ++j) {
+    lo[j] = inf;
+    hi[j] = -inf;
+  }
+  const size_t blocks = n - n % L;
+
+  for (size_t i = 0; i < blocks; i += L)
+    for (size_t j = 0; j < L; ++j) {
+      double d = A * x[i + j] + B * y[i + j] + C;
+      double p = dir_x * x[i + j] + dir_y * y[i + j];
+      if (Store)
+        t[i + j] = p;
+      s[j] += d * d;
+      lo[j] = (p < lo[j]) ? p : lo[j];
+      hi[j] = (p > hi[j]) ? p : hi[j];
+    }
+
+  double sum = sumLanes(s);
+  double t_min = inf, t_max = -inf;
+  for (size_t j = 0; j < L; ++j) {
+    t_min = (lo[j] < t_min) ? lo[j] : t_min;
+    t_max = (hi[j] > t_max) ? hi[j] : t_max;
+  }
+
+  for (size_t i = blocks; i < n; ++i) {
+    double d = A * x[i] + B * y[i] + C;
+    double p = dir_x * x[i] + dir_y * y[i];
+    if (Store)
+      t[i] = p;
+    sum += d * d;
+    t_min = (p < t_min) ? p : t_min;
+    t_max = (p > t_max) ? p : t_max;
+  }
+
+  bounds[0] = t_min;
+  bounds[1] = t_max;
+  return sum;
+}
+
+double projectOntoLine(const double* x, const double* y, size_t n,
+                       double A, double B, double C,
+                       double dir_x, double dir_y,
+                       double* t, double bounds[2]) {
+  if (t)
+    return project<true>(x, y, n, A, B, C, dir_x, dir_y, t, bounds);
+  else
+    return project<false>(x, y, n, A, B, C, dir_x, dir_y, t, bounds);
+}
+
+void transform(const double* x_in, const double* y_in, size_t n,
+               double c, double s, double t_x, double t_y,
+               double* x_out, double* y_out) {
+  const size_t blocks = n - n % L;
+
+  // A block is loaded before it is stored, which keeps the in place
+  // transformation vectorized without run time alias checks
+  for (size_t i = 0; i < blocks; i += L) {
+    double x[L], y[L];
+    for (size_t j = 0; j < L; ++j) {
+      x[j] = x_in[i + j];
+      y[j] = y_in[i + j];
+    }
+    for (size_t j = 0; j < L; ++j) {
+      x_out[i + j] = c * x[j] - s * y[j] + t_x;
+      y_out[i + j] = s * x[j] + c * y[j] + t_y;
+    }
+  }
+
+  for (size_t i = blocks; i < n; ++i) {
+    double x = x_in[i];
+    double y = y_in[i];
+    x_out[i] = c * x - s * y + t_x;
+    y_out[i] = s * x + c * y + t_y;
+  }
+}
+
+} // end anonymous namespace
+
+extern const KernelTable table;
+
+const KernelTable table = {
+  FIGFIT_KERNEL_ISA_ENUM,
+  moments,
+  cubicMoments,
+  lineDistanceSquared,
+  circleDistanceSquared,
+  countInAnnulus,
+  circleCenterStep,
+  projectOntoLine,
+  transform
+};
+
+} // end namespace FIGFIT_KERNEL_ISA
+
+} // end namespace kernels
+
+} // end namespace figfit
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../figure_fitter.h"
+#include "../kernels.h"
+#include "../moments.h"
+#include "../point_cloud.h"
+#include "../spsc_queue.h"
+
+namespace figfit
+{
+
+/**
+ * @class StreamingFitter streaming_fitter.h
+ *
+ * @brief Line and circle fits of point files larger than memory
+ *
+ * Reads a file of points in chunks of fixed size and reduces them into
+ * moments, from which the figures are fitted. The file is a raw sequence of
+ * native double pairs (x0, y0, x1, y1, ...). A reader thread fills the
+ * chunks while the calling thread reduces the previous ones: the chunks are
+ * passed back and forth through two SpscQueue objects, so reading overlaps
+ * with computation and memory is bounded by a few chunks regardless of the
+ * size of the file. A thread waiting for a chunk spins for a while and then
+ * sleeps, so a stream bound by the disk does not keep a core busy.
+ */
+class StreamingFitter
+{
+public:
+
+  /**
+   * @brief Construction with given chunk size (default)
+   *
+   * @param chunk is the number of points read at once
+   * @param chunks is the number of chunks in flight (at least two)
+   */
+  explicit StreamingFitter(size_t chunk = 65536, size_t chunks = 3) :
+    chunk_(std::max<size_t>(chunk, 1)),
+    buffers_(std::max<size_t>(chunks, 2))
+  {}
+
+  /**
+   * @brief Call function for every chunk of points of a file
+   *
+   * The function is called on the calling thread, in the order of the file,
+   * with a view that is valid only during the call. If it throws, the reader
+   * stops before its next read and the exception is rethrown.
+   *
+   * @param path is the path of the file
+   * @param function is called as function(const PointCloudView&)
+   *
+   * @throw std::runtime_error if the file cannot be read or is truncated
+   */
+  template <typename Function>
+  void read(const std::string& path, const Function& function) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+      throw std::runtime_error("Could not open file " + path);
+
+    SpscQueue<size_t> free(buffers_.size());
+    SpscQueue<size_t> full(buffers_.size());
+    for (size_t i = 0; i < buffers_.size(); ++i)
+      free.push(i);
+
+    Wakeup free_wakeup, full_wakeup;
+    std::atomic<bool> stopped(false);
+
+    std::exception_ptr error, read_error;
+    std::thread reader([&] {
+      while (true) {
+        size_t i = pop(free, free_wakeup);
+
+        Buffer& buffer = buffers_[i];
+        if (stopped.load(std::memory_order_relaxed)) {
+          buffer.points.resize(0);
+          push(full, full_wakeup, i);
+          return;
+        }
+
+        buffer.raw.resize(2 * chunk_);
+        size_t count = fread(buffer.raw.data(), sizeof(double),
+                             buffer.raw.size(), file);
+
+        if (count % 2 != 0 || (count < buffer.raw.size() && ferror(file))) {
+          read_error = std::make_exception_ptr(std::runtime_error(
+                    "Error while reading file " + path));
+          count = 0;
+        }
+
+        buffer.points.resize(count / 2);
+        for (size_t j = 0; j < count / 2; ++j) {
+          buffer.points.x(j) = buffer.raw[2 * j];
+          buffer.points.y(j) = buffer.raw[2 * j + 1];
+        }
+
+        push(full, full_wakeup, i);
+        if (count == 0)
+          return;
+      }
+    });
+
+    // An empty chunk marks the end of the file, an error or the stop
+    try {
+      while (true) {
+        size_t i = pop(full, full_wakeup);
+        if (buffers_[i].points.empty())
+          break;
+
+        function(buffers_[i].points.view());
+        push(free, free_wakeup, i);
+      }
+    }
+    catch (...) {
+      // Stop the reader and drop the chunks read ahead before rethrowing
+      error = std::current_exception();
+      stopped.store(true, std::memory_order_relaxed);
+      while (true) {
+        size_t i = pop(full, full_wakeup);
+        if (buffers_[i].points.empty())
+          break;
+        push(free, free_wakeup, i);
+      }
+    }
+
+    reader.join();
+    fclose(file);
+
+    if (error)
+      std::rethrow_exception(error);
+    if (read_error)
+      std::rethrow_exception(read_error);
+  }
+
+  /**
+   * @brief Find moments of points of a file
+   *
+   * @param path is the path of the file
+   *
+   * @return scatter moments of the points
+   */
+  Moments findMoments(const std::string& path) {
+    Moments m;
+    read(path, [&m](const PointCloudView& points) {
+      m.addBlock(points.xData(), points.yData(), points.size());
+    });
+    return m;
+  }
+
+  /**
+   * @brief Find moments of points of a file up to the third order
+   *
+   * @param path is the path of the file
+   *
+   * @return scatter moments of the points
+   */
+  CubicMoments findCubicMoments(const std::string& path) {
+    CubicMoments m;
+    read(path, [&m](const PointCloudView& points) {
+      m.addBlock(points.xData(), points.yData(), points.size());
+    });
+    return m;
+  }
+
+  /**
+   * @brief Fit line to points of a file
+   *
+   * @param path is the path of the file
+   * @param l is a placeholder for the resulting line
+   *
+   * @throw std::logic_error if there are less than two points in the file
+   * @throw std::runtime_error if the file cannot be read or the line cannot
+   * be determined
+   */
+  void fitLine(const std::string& path, Line& l) {
+    FigureFitter::fitLine(findMoments(path), l);
+  }
+
+  /**
+   * @brief Fit line to points of a file and get variance
+   *
+   * The variance is found from the moments, in a single pass over the file.
+   *
+   * @param path is the path of the file
+   * @param l is a placeholder for the resulting line
+   * @param variance is a placeholder for the variance of points around line
+   */
+  void fitLine(const std::string& path, Line& l, double& variance) {
+    FigureFitter::fitLine(findMoments(path), l, variance);
+  }
+
+  /**
+   * @brief Fit circle to points of a file
+   *
+   * @param path is the path of the file
+   * @param c is a placeholder for the resulting circle
+   *
+   * @throw std::runtime_error if the file cannot be read, there are less than
+   * three points in the file or all of the points are collinear
+   */
+  void fitCircle(const std::string& path, Circle& c) {
+    FigureFitter::fitCircle(findCubicMoments(path), c);
+  }
+
+  /**
+   * @brief Fit circle to points of a file and get variance
+   *
+   * The variance requires the second pass over the file.
+   *
+   * @param path is the path of the file
+   * @param c is a placeholder for the resulting circle
+   * @param variance is a placeholder for the variance of points around circle
+   */
+  void fitCircle(const std::string& path, Circle& c, double& variance) {
+    CubicMoments m = findCubicMoments(path);
+    FigureFitter::fitCircle(m, c);
+
+    variance = 0.0;
+    const Point center = c.center();
+    const double radius = c.radius();
+
+    read(path, [&](const PointCloudView& points) {
+      variance += kernels::active().circleDistanceSquared(
+          points.xData(), points.yData(), points.size(),
+          center.x, center.y, radius);
+    });
+    variance /= m.n;
+  }
+
+private:
+
+  /**
+   * @struct Buffer
+   *
+   * @brief Chunk of points in flight
+   */
+  struct Buffer
+  {
+    std::vector<double> raw;  /**< @brief Interleaved coordinates as read */
+    PointCloud2D points;      /**< @brief Coordinates of points */
+  };
+
+  /**
+   * @struct Wakeup
+   *
+   * @brief Sleeping place of the thread popping from a queue
+   */
+  struct Wakeup
+  {
+    std::mutex mutex;                 /**< @brief Guard of sleeping */
+    std::condition_variable signal;   /**< @brief Signal of a new chunk */
+    std::atomic<bool> sleeping;       /**< @brief Flag of sleeping thread */
+
+    Wakeup() :
+      sleeping(false)
+    {}
+  };
+
+  /**
+   * @brief Number of polls of an empty queue before sleeping
+   */
+  static const size_t spin_limit = 2048;
+
+  /**
+   * @brief Push chunk index to a queue and wake up its popping thread
+   *
+   * The queues hold all of the chunks, hence the push never fails. The fence
+   * orders the push before the check of the flag, the popping thread orders
+   * the raise of the flag before its last check of the queue, so at least one
+   * of them sees the other.
+   */
+  static void push(SpscQueue<size_t>& queue, Wakeup& wakeup, size_t i) {
+    queue.push(i);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!wakeup.sleeping.load(std::memory_order_relaxed))
+      return;
+
+    std::lock_guard<std::mutex> lock(wakeup.mutex);
+    wakeup.signal.notify_one();
+  }
+
+  /**
+   * @brief Pop chunk index from a queue
+   *
+   * Polls the queue and, after spin_limit failed polls in a row, sleeps until
+   * the pushing thread wakes it up.
+   */
+  static size_t pop(SpscQueue<size_t>& queue, Wakeup& wakeup) {
+    size_t i;
+    size_t spins = 0;
+
+    while (!queue.pop(i)) {
+      if (++spins < spin_limit) {
+        pause();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(wakeup.mutex);
+      wakeup.sleeping.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      wakeup.signal.wait(lock, [&queue] { return queue.size() > 0; });
+      wakeup.sleeping.store(false, std::memory_order_relaxed);
+      spins = 0;
+    }
+
+    return i;
+  }
+
+  /**
+   * @brief Hint to the processor of a spin-wait loop
+   */
+  static void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  size_t chunk_;                  /**< @brief Number of points of a chunk */
+  std::vector<Buffer> buffers_;   /**< @brief Chunks in flight */
+};
+
+} // end namespace figfit
@@ -0,0 +1,1170 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../convex_hull.h"
+#include "../enclosing_circle.h"
+#include "../figure_fitter.h"
+#include "../figure_log.h"
+#include "../moments.h"
+#include "../parallel_fitter.h"
+#include "../point_cloud.h"
+#include "../polyline_simplifier.h"
+#include "../scan_pipeline.h"
+#include "../spsc_queue.h"
+#include "../text_reader.h"
+#include "../thread_pool.h"
+#include "../figures/ellipse.h"
+#include "../figures/rectangle.h"
+
+using namespace std;
+using namespace figfit;
+
+/*
+ * Known-answer tests of the fits and the geometric primitives. Every test is
+ * a function listed in main(). Failed checks are reported with their location
+ * and the program exits with 1. A test name given as the argument runs only
+ * that test.
+ */
+
+//
+// Harness
+//
+
+size_t failures = 0;
+
+void check(bool condition, const char* expression, const char* file,
+           int line) {
+  if (!condition) {
+    cerr << file << ":" << line << ": check failed: " << expression << "\n";
+    failures++;
+  }
+}
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+bool isNear(double a, double b, double tolerance = 1e-9) {
+  return std::abs(a - b) <= tolerance * std::max(1.0, std::abs(b));
+}
+
+bool isNear(const Point& a, const Point& b, double tolerance = 1e-9) {
+  return isNear(a.x, b.x, tolerance) && isNear(a.y, b.y, tolerance);
+}
+
+/*
+ * Check if function throws exception of given type
+ */
+template <typename Exception>
+bool throws(const function<void()>& f) {
+  try {
+    f();
+  }
+  catch (const Exception&) {
+    return true;
+  }
+  catch (...) {}
+  return false;
+}
+
+/*
+ * Difference of angles of undirected axes, in range [0, pi/2]
+ */
+double axisAngleBetween(double a, double b) {
+  return std::abs(remainder(a - b, M_PI));
+}
+
+//
+// Segment
+//
+
+void testSegment() {
+  // Points i = 0..20 of the line y = 2x + 1, evenly spaced and shuffled
+  const Vec step(0.5, 1.0);
+  auto along = [&step](double i) { return Point(-3.0, -5.0) + i * step; };
+
+  vector<size_t> order(21);
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  shuffle(order.begin(), order.end(), minstd_rand(5));
+
+  PointCloud2D points;
+  for (size_t i : order)
+    points.push_back(along(i).x, along(i).y);
+
+  FigureFitter fitter(points);
+  Segment s;
+  double variance;
+
+  // The first and the last point in the order of the set
+  fitter.fitSegment(s, SegmentExtent::FirstLast);
+  CHECK(isNear(s.startPoint(), along(order.front())));
+  CHECK(isNear(s.endPoint(), along(order.back())));
+
+  // The extreme points, directed from the first towards the last point
+  bool forward = order.back() > order.front();
+  fitter.fitSegment(s, variance, SegmentExtent::MinMax);
+  CHECK(isNear(s.startPoint(), along(forward ? 0 : 20)));
+  CHECK(isNear(s.endPoint(), along(forward ? 20 : 0)));
+  CHECK(isNear(variance, 0.0));
+
+  // Any other order spans the same extreme points
+  for (unsigned seed = 1; seed < 5; ++seed) {
+    shuffle(order.begin(), order.end(), minstd_rand(seed));
+    PointCloud2D reordered;
+    for (size_t i : order)
+      reordered.push_back(along(i).x, along(i).y);
+
+    Segment r;
+    FigureFitter(reordered).fitSegment(r, SegmentExtent::MinMax);
+    bool same = isNear(r.startPoint(), s.startPoint()) &&
+                isNear(r.endPoint(), s.endPoint());
+    bool reversed = isNear(r.startPoint(), s.endPoint()) &&
+                    isNear(r.endPoint(), s.startPoint());
+    CHECK(same != reversed);
+    CHECK(same == ((order.back() > order.front()) == forward));
+  }
+
+  // Trimming 10% drops two points at each end, whose distances from the end
+  // points are one and two steps
+  fitter.fitSegment(s, variance, SegmentExtent::Trimmed, 0.1);
+  CHECK(isNear(s.startPoint(), along(forward ? 2 : 18)));
+  CHECK(isNear(s.endPoint(), along(forward ? 18 : 2)));
+  CHECK(isNear(variance, 10.0 * step.lengthSquared() / 21));
+
+  Segment unchanged = s;
+  CHECK(fitter.tryFitSegment(s, SegmentExtent::Trimmed, 0.5) ==
+        FitStatus::InvalidArgument);
+  CHECK(s.startPoint() == unchanged.startPoint());
+}
+
+//
+// Circle of known radius
+//
+
+void testCircleOfRadius() {
+  const Point center(3.0, -2.0);
+  const double radius = 5.0;
+
+  // Noisy arc of 70 deg
+  PointCloud2D arc;
+  for (size_t i = 0; i < 200; ++i) {
+    double t = 0.2 + 1.2 * i / 200;
+    double r = radius + 0.01 * sin(7919.0 * i);
+    arc.push_back(center.x + r * cos(t), center.y + r * sin(t));
+  }
+
+  Circle c;
+  double variance;
+  FigureFitter(arc).fitCircleOfRadius(c, radius, variance);
+  CHECK(c.radius() == radius);
+  CHECK(isNear(c.center(), center, 0.01));
+  CHECK(variance < 1e-4);
+
+  // Gauss-Newton steps converge to the least squares center, where the
+  // gradient of the sum of squared residuals vanishes
+  Vec gradient(0.0, 0.0);
+  for (size_t i = 0; i < arc.size(); ++i) {
+    Vec d = arc.point(i) - c.center();
+    gradient += (d.length() - radius) / d.length() * d;
+  }
+  CHECK(gradient.length() < 1e-9);
+
+  // RANSAC rejects 40% of outliers scattered inside the circle
+  PointCloud2D cluttered;
+  minstd_rand engine(11);
+  uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+  uniform_real_distribution<double> distance(0.0, 0.6 * radius);
+  for (size_t i = 0; i < 100; ++i) {
+    if (i % 5 < 2) {
+      double t = angle(engine), d = distance(engine);
+      cluttered.push_back(center.x + d * cos(t), center.y + d * sin(t));
+    }
+    else
+      cluttered.push_back(arc.x(2 * i), arc.y(2 * i));
+  }
+
+  Circle robust;
+  double robust_variance;
+  FigureFitter fitter(cluttered);
+  fitter.fitCircleOfRadiusRobust(robust, radius, 0.05, robust_variance);
+  CHECK(robust.radius() == radius);
+  CHECK(isNear(robust.center(), center, 0.01));
+  CHECK(robust_variance < 1e-4);
+
+  // whereas the plain fit is pulled off by them
+  fitter.fitCircleOfRadius(c, radius);
+  CHECK(!isNear(c.center(), center, 0.1));
+
+  // The result is repeatable
+  Circle again;
+  fitter.fitCircleOfRadiusRobust(again, radius, 0.05);
+  CHECK(again.center() == robust.center());
+}
+
+//
+// Ellipse
+//
+
+void testEllipse() {
+  const Ellipse expected(Point(3.0, -1.0), 5.0, 2.0, 0.4);
+
+  PointCloud2D points;
+  for (size_t i = 0; i < 40; ++i) {
+    double t = 2.0 * M_PI * i / 40;
+    double u = 5.0 * cos(t), v = 2.0 * sin(t);
+    points.push_back(3.0 + u * cos(0.4) - v * sin(0.4),
+                     -1.0 + u * sin(0.4) + v * cos(0.4));
+  }
+
+  FigureFitter fitter(points);
+  Ellipse e;
+  double variance;
+  fitter.fitEllipse(e, variance);
+
+  CHECK(isNear(e.center(), expected.center(), 1e-7));
+  CHECK(isNear(e.semiMajorAxis(), 5.0, 1e-7));
+  CHECK(isNear(e.semiMinorAxis(), 2.0, 1e-7));
+  CHECK(axisAngleBetween(e.angle(), 0.4) < 1e-7);
+  CHECK(variance < 1e-12);
+
+  // Circle is an ellipse with equal axes
+  points.clear();
+  for (size_t i = 0; i < 12; ++i)
+    points.push_back(1.0 + 2.0 * cos(0.5 * i), 2.0 + 2.0 * sin(0.5 * i));
+  fitter.assign(points);
+  fitter.fitEllipse(e);
+
+  CHECK(isNear(e.center(), Point(1.0, 2.0), 1e-7));
+  CHECK(isNear(e.semiMajorAxis(), 2.0, 1e-7));
+  CHECK(isNear(e.semiMinorAxis(), 2.0, 1e-7));
+
+  // Degenerate sets
+  fitter.assign(vector<Point>(6, Point(1.0, 1.0)));
+  CHECK(fitter.tryFitEllipse(e) == FitStatus::Degenerate);
+
+  fitter.assign(vector<Point>{Point(0, 0), Point(1, 1), Point(2, 2),
+                                           Point(3, 3), Point(4, 4), Point(5, 5)});
+  CHECK(fitter.tryFitEllipse(e) == FitStatus::Collinear);
+
+  fitter.assign(vector<Point>{Point(0, 0), Point(1, 0), Point(0, 1)});
+  CHECK(fitter.tryFitEllipse(e) == FitStatus::TooFewPoints);
+}
+
+//
+// Rectangle
+//
+
+/*
+ * Check if rectangles are equal up to the numbering of their corners
+ */
+bool isSameRectangle(const Rectangle& a, const Rectangle& b,
+                     double tolerance) {
+  for (int i = 0; i < 4; ++i) {
+    bool found = false;
+    for (int j = 0; j < 4; ++j)
+      found = found || isNear(a.corner(i), b.corner(j), tolerance);
+    if (!found)
+      return false;
+  }
+  return true;
+}
+
+/*
+ * Sample sides of rectangle from first corner to corner first + count
+ */
+void sampleSides(const Rectangle& r, int first, int count, size_t per_side,
+                 PointCloud2D& points) {
+  points.clear();
+  for (int side = first; side < first + count; ++side) {
+    Point a = r.corner(side), b = r.corner(side + 1);
+    for (size_t i = 0; i <= per_side; ++i)
+      points.push_back(a + (b - a) * (double(i) / per_side));
+  }
+}
+
+void testRectangle() {
+  // The angle is found by a search on a grid of step pi/36 refined three
+  // times by 4, the rectangle is exact on the grid and near it elsewhere
+  const Rectangle expected(Point(-1.0, 2.0), 4.0, 2.0, M_PI / 6.0);
+  const double resolution = M_PI / 36.0 / 64.0;
+  PointCloud2D points;
+  FigureFitter fitter;
+  Rectangle r;
+  double variance;
+
+  // Fully visible
+  sampleSides(expected, 0, 4, 20, points);
+  fitter.assign(points);
+  fitter.fitRectangle(r, variance);
+
+  CHECK(isSameRectangle(r, expected, 1e-9));
+  CHECK(variance < 1e-12);
+
+  // L-shape of two sides seen from one corner
+  sampleSides(expected, 1, 2, 30, points);
+  fitter.assign(points);
+  fitter.fitRectangle(r, variance);
+
+  CHECK(isSameRectangle(r, expected, 1e-9));
+  CHECK(variance < 1e-12);
+
+  // Angle off the grid
+  const Rectangle rotated(Point(-1.0, 2.0), 4.0, 2.0, 0.3);
+  sampleSides(rotated, 0, 4, 20, points);
+  fitter.assign(points);
+  fitter.fitRectangle(r, variance);
+
+  CHECK(axisAngleBetween(r.angle(), 0.3) < resolution);
+  CHECK(isSameRectangle(r, rotated, 4.0 * resolution));
+  CHECK(variance < resolution * resolution);
+
+  // Axis-aligned square
+  const Rectangle square(Point(5.0, 5.0), 2.0, 2.0, 0.0);
+  sampleSides(square, 0, 4, 8, points);
+  fitter.assign(points);
+  fitter.fitRectangle(r);
+
+  CHECK(isSameRectangle(r, square, 1e-6));
+
+  fitter.assign(vector<Point>{Point(0, 0), Point(1, 0)});
+  CHECK(fitter.tryFitRectangle(r) == FitStatus::TooFewPoints);
+}
+
+//
+// Convex hull
+//
+
+/*
+ * Get hull vertices as sorted indices
+ */
+vector<size_t> sortedHull(const ConvexHull& hull) {
+  vector<size_t> indices = hull.indices();
+  sort(indices.begin(), indices.end());
+  return indices;
+}
+
+/*
+ * Check if hull vertices are in counter-clockwise order
+ */
+bool isCounterClockwise(const ConvexHull& hull, const PointCloudView& points) {
+  const vector<size_t>& h = hull.indices();
+  for (size_t i = 0; i < h.size(); ++i) {
+    Point a = points.point(h[i]);
+    Point b = points.point(h[(i + 1) % h.size()]);
+    Point c = points.point(h[(i + 2) % h.size()]);
+    if ((b - a).cross(c - b) <= 0.0)
+      return false;
+  }
+  return true;
+}
+
+void testConvexHull() {
+  ConvexHull hull;
+  PointCloud2D points;
+
+  // Empty, single and duplicate points
+  hull.compute(points);
+  CHECK(hull.size() == 0);
+
+  points.push_back(1.0, 2.0);
+  hull.compute(points);
+  CHECK(sortedHull(hull) == vector<size_t>{0});
+
+  points.push_back(1.0, 2.0);
+  hull.compute(points);
+  CHECK(sortedHull(hull) == vector<size_t>{0});
+
+  // Collinear points reduce to the endpoints
+  points = PointCloud2D(vector<Point>{
+      Point(2, 1), Point(0, 0), Point(4, 2), Point(1, 0.5), Point(3, 1.5)});
+  hull.compute(points);
+  CHECK((sortedHull(hull) == vector<size_t>{1, 2}));
+  hull.computeFromScan(points);
+  CHECK((sortedHull(hull) == vector<size_t>{1, 2}));
+  CHECK(!hull.isEnclosing(points, Point(2, 1)));
+
+  // Square with points inside and in the middles of the edges
+  points = PointCloud2D(vector<Point>{
+      Point(0, 0), Point(1, 0), Point(2, 0), Point(2, 1), Point(2, 2),
+      Point(1, 2), Point(0, 2), Point(0, 1), Point(1, 1), Point(0.5, 1.5),
+      Point(1.5, 0.5)});
+  hull.compute(points);
+  CHECK((sortedHull(hull) == vector<size_t>{0, 2, 4, 6}));
+  CHECK(isCounterClockwise(hull, points));
+  CHECK(hull.isEnclosing(points, Point(1, 1)));
+  CHECK(hull.isEnclosing(points, Point(2, 1)));
+  CHECK(!hull.isEnclosing(points, Point(2.5, 1)));
+
+  // Scan of a corner and an arc ordered by angle gives the same hull
+  points.clear();
+  for (size_t i = 0; i <= 40; ++i) {
+    double angle = M_PI * i / 40;
+    double range = (i % 10 == 5) ? 1.0 : 2.0 + 0.1 * sin(3.0 * angle);
+    points.push_back(range * cos(angle), range * sin(angle));
+  }
+  hull.compute(points);
+  vector<size_t> expected = sortedHull(hull);
+  hull.computeFromScan(points);
+  CHECK(sortedHull(hull) == expected);
+  CHECK(isCounterClockwise(hull, points));
+}
+
+//
+// Enclosing circle
+//
+
+/*
+ * Check if circle encloses all of the points
+ */
+bool isEnclosing(const Circle& c, const PointCloudView& points) {
+  for (size_t i = 0; i < points.size(); ++i)
+    if ((points.point(i) - c.center()).length() > c.radius() * (1 + 1e-9))
+      return false;
+  return true;
+}
+
+void testEnclosingCircle() {
+  EnclosingCircle enclosing;
+  PointCloud2D points;
+
+  // Empty, single and duplicate points
+  Circle c = enclosing.find(points);
+  CHECK(c.radius() == 0.0);
+
+  points.push_back(1.0, 2.0);
+  c = enclosing.find(points);
+  CHECK(isNear(c.center(), Point(1.0, 2.0)));
+  CHECK(c.radius() == 0.0);
+
+  points.push_back(1.0, 2.0);
+  points.push_back(1.0, 2.0);
+  c = enclosing.find(points);
+  CHECK(isNear(c.center(), Point(1.0, 2.0)));
+  CHECK(c.radius() == 0.0);
+
+  // Collinear points are enclosed by the circle over the endpoints
+  points = PointCloud2D(vector<Point>{
+      Point(2, 1), Point(0, 0), Point(4, 2), Point(1, 0.5), Point(3, 1.5)});
+  c = enclosing.find(points);
+  CHECK(isNear(c.center(), Point(2.0, 1.0)));
+  CHECK(isNear(c.radius(), sqrt(5.0)));
+
+  // Square with points inside
+  points = PointCloud2D(vector<Point>{
+      Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2), Point(1, 1),
+      Point(0.5, 1.5)});
+  c = enclosing.find(points);
+  CHECK(isNear(c.center(), Point(1.0, 1.0)));
+  CHECK(isNear(c.radius(), sqrt(2.0)));
+
+  // Acute triangle is enclosed by its circumcircle
+  points = PointCloud2D(vector<Point>{
+      Point(0, 0), Point(4, 0), Point(2, 3)});
+  c = enclosing.find(points);
+  CHECK(isNear(c.center(), Point(2.0, 5.0 / 6.0)));
+  CHECK(isNear(c.radius(), 13.0 / 6.0));
+
+  // The circle of the hull vertices equals that of all of the points
+  points.clear();
+  for (size_t i = 0; i < 200; ++i)
+    points.push_back(3.0 * cos(0.7 * i) * sin(0.13 * i),
+                     2.0 * sin(0.3 * i) + 0.01 * i);
+  c = enclosing.find(points);
+  CHECK(isEnclosing(c, points));
+
+  ConvexHull hull;
+  hull.compute(points);
+  Circle from_hull = enclosing.find(points, hull.indices());
+  CHECK(isNear(from_hull.center(), c.center()));
+  CHECK(isNear(from_hull.radius(), c.radius()));
+}
+
+//
+// Polyline simplification
+//
+
+void testPolylineSimplifier() {
+  PolylineSimplifier simplifier;
+  PointCloud2D points;
+  vector<size_t> vertices;
+
+  // Short polylines are kept
+  simplifier.simplifyDouglasPeucker(points, 0.1, vertices);
+  CHECK(vertices.empty());
+
+  points.push_back(0.0, 0.0);
+  points.push_back(1.0, 0.0);
+  simplifier.simplifyVisvalingam(points, 0.1, vertices);
+  CHECK((vertices == vector<size_t>{0, 1}));
+
+  // Straight line reduces to its endpoints
+  points.clear();
+  for (size_t i = 0; i <= 20; ++i)
+    points.push_back(0.5 * i, 1.0 + 0.25 * i);
+
+  simplifier.simplifyDouglasPeucker(points, 1e-9, vertices);
+  CHECK((vertices == vector<size_t>{0, 20}));
+  simplifier.simplifyVisvalingam(points, 1e-9, vertices);
+  CHECK((vertices == vector<size_t>{0, 20}));
+
+  // L-shape keeps the corner, small zigzag is removed within tolerance
+  points.clear();
+  for (size_t i = 0; i <= 10; ++i)
+    points.push_back(i, (i % 2) * 0.01);
+  for (size_t i = 1; i <= 10; ++i)
+    points.push_back(10.0 + (i % 2) * 0.01, i);
+
+  simplifier.simplifyDouglasPeucker(points, 0.05, vertices);
+  CHECK((vertices == vector<size_t>{0, 10, 20}));
+  // The zigzag spans triangles of area up to 0.5 * 10 * 0.01
+  simplifier.simplifyVisvalingam(points, 0.1, vertices);
+  CHECK((vertices == vector<size_t>{0, 10, 20}));
+
+  // Zero tolerance keeps every vertex off the line of its neighbours
+  simplifier.simplifyDouglasPeucker(points, 0.0, vertices);
+  CHECK(vertices.size() == points.size());
+
+  // Coinciding vertices are skipped by the conversion into segments
+  points = PointCloud2D(vector<Point>{
+      Point(0, 0), Point(0, 0), Point(1, 0), Point(1, 0), Point(1, 1)});
+  SegmentArray segments;
+  PolylineSimplifier::toSegments(points, {0, 1, 2, 3, 4}, segments);
+  CHECK(segments.size() == 2);
+  CHECK(isNear(segments[0].startPoint(), Point(0, 0)));
+  CHECK(isNear(segments[0].endPoint(), Point(1, 0)));
+  CHECK(isNear(segments[1].startPoint(), Point(1, 0)));
+  CHECK(isNear(segments[1].endPoint(), Point(1, 1)));
+}
+
+//
+// Moments
+//
+
+/*
+ * Points on a noisy arc far from the origin, as in a scan of a large circle
+ */
+void sampleArc(size_t n, PointCloud2D& points) {
+  points.clear();
+  for (size_t i = 0; i < n; ++i) {
+    double t = 2.0 * i / n;
+    double r = 50.0 + 0.01 * sin(7919.0 * i);
+    points.push_back(1000.0 + r * cos(t), -500.0 + r * sin(t));
+  }
+}
+
+bool isNear(const CubicMoments& a, const CubicMoments& b, double tolerance) {
+  // Sums are compared relative to the scale of the second order ones, the
+  // third order ones are larger by about the radius of the arc
+  double scale = std::max(a.s_xx, a.s_yy);
+  return a.n == b.n && isNear(a.mean_x, b.mean_x, tolerance) &&
+         isNear(a.mean_y, b.mean_y, tolerance) &&
+         std::abs(a.s_xx - b.s_xx) <= tolerance * scale &&
+         std::abs(a.s_xy - b.s_xy) <= tolerance * scale &&
+         std::abs(a.s_yy - b.s_yy) <= tolerance * scale &&
+         std::abs(a.s_xxx - b.s_xxx) <= tolerance * scale * 50.0 &&
+         std::abs(a.s_xxy - b.s_xxy) <= tolerance * scale * 50.0 &&
+         std::abs(a.s_xyy - b.s_xyy) <= tolerance * scale * 50.0 &&
+         std::abs(a.s_yyy - b.s_yyy) <= tolerance * scale * 50.0;
+}
+
+void testMoments() {
+  PointCloud2D points;
+  sampleArc(10000, points);
+
+  CubicMoments single;
+  for (size_t i = 0; i < points.size(); ++i)
+    single.add(points.x(i), points.y(i));
+
+  // Parts of uneven size, the empty one included
+  const size_t bounds[] = {0, 1, 1, 700, 4096, 4097, 9000, 10000};
+  CubicMoments merged;
+  for (size_t k = 0; k + 1 < sizeof(bounds) / sizeof(bounds[0]); ++k) {
+    CubicMoments part;
+    part.addBlock(points.xData() + bounds[k], points.yData() + bounds[k],
+                  bounds[k + 1] - bounds[k]);
+    merged.merge(part);
+  }
+
+  CHECK(isNear(merged, single, 1e-9));
+
+  // Merging with empty moments keeps them
+  CubicMoments copy = merged;
+  copy.merge(CubicMoments());
+  CHECK(isNear(copy, merged, 0.0));
+
+  CubicMoments empty;
+  empty.merge(merged);
+  CHECK(isNear(empty, merged, 0.0));
+
+  // Second order moments of the same parts
+  Moments lower;
+  lower.addBlock(points.xData(), points.yData(), 5000);
+  Moments upper;
+  upper.addBlock(points.xData() + 5000, points.yData() + 5000, 5000);
+  lower.merge(upper);
+
+  CHECK(lower.n == single.n);
+  CHECK(isNear(lower.mean_x, single.mean_x));
+  CHECK(isNear(lower.mean_y, single.mean_y));
+  CHECK(isNear(lower.s_xx, single.s_xx, 1e-9));
+  CHECK(isNear(lower.s_xy, single.s_xy, 1e-9));
+  CHECK(isNear(lower.s_yy, single.s_yy, 1e-9));
+}
+
+//
+// Parallel fitter
+//
+
+void testParallelFitter() {
+  PointCloud2D points;
+  sampleArc(100000, points);
+
+  ThreadPool pool(4);
+  ParallelFitter fitter(pool, 1000);
+
+  Circle first;
+  double first_variance;
+  fitter.fitCircle(points, first, first_variance);
+
+  // The fit agrees with the sequential one
+  Circle sequential;
+  FigureFitter(points).fitCircle(sequential);
+  CHECK(isNear(first.center(), sequential.center(), 1e-9));
+  CHECK(isNear(first.radius(), sequential.radius(), 1e-9));
+
+  // and does not change between runs nor pools of the same size
+  ThreadPool other(4);
+  ParallelFitter other_fitter(other, 1000);
+  for (size_t run = 0; run < 10; ++run) {
+    Circle c;
+    double variance;
+    (run % 2 ? other_fitter : fitter).fitCircle(points, c, variance);
+    CHECK(c.center() == first.center());
+    CHECK(c.radius() == first.radius());
+    CHECK(variance == first_variance);
+  }
+
+  Line l, l_other;
+  double variance, variance_other;
+  fitter.fitLine(points, l, variance);
+  other_fitter.fitLine(points, l_other, variance_other);
+  CHECK(l.A() == l_other.A() && l.B() == l_other.B() && l.C() == l_other.C());
+  CHECK(variance == variance_other);
+
+  // More workers than points
+  PointCloud2D few;
+  sampleArc(3, few);
+  Circle c;
+  CHECK(fitter.tryFitCircle(few, c) == FitStatus::Ok);
+  few.resize(1);
+  CHECK(fitter.tryFitLine(few, l) == FitStatus::TooFewPoints);
+}
+
+//
+// SPSC queue
+//
+
+void testSpscQueue() {
+  SpscQueue<int> queue(3);
+  CHECK(queue.capacity() == 4);
+
+  int value;
+  CHECK(!queue.pop(value));
+
+  // Many rounds of partial fills move the indices around the slots
+  int pushed = 0, popped = 0;
+  for (int round = 0; round < 100; ++round) {
+    for (int i = 0; i < 1 + round % 4; ++i)
+      CHECK(queue.push(pushed++));
+    for (int i = 0; i < 1 + round % 4; ++i) {
+      CHECK(queue.pop(value));
+      CHECK(value == popped++);
+    }
+    CHECK(queue.size() == 0);
+  }
+
+  // Full queue rejects the push and keeps its elements
+  for (int i = 0; i < 4; ++i)
+    CHECK(queue.push(i));
+  CHECK(!queue.push(4));
+  CHECK(queue.size() == 4);
+  for (int i = 0; i < 4; ++i) {
+    CHECK(queue.pop(value));
+    CHECK(value == i);
+  }
+  CHECK(!queue.pop(value));
+
+  // Elements passed between two threads arrive in order
+  const int n = 100000;
+  std::thread producer([&queue] {
+    for (int i = 0; i < n; ++i)
+      while (!queue.push(i))
+        this_thread::yield();
+  });
+
+  bool ordered = true;
+  for (int i = 0; i < n; ++i) {
+    while (!queue.pop(value))
+      this_thread::yield();
+    ordered = ordered && value == i;
+  }
+  producer.join();
+  CHECK(ordered);
+}
+
+//
+// Thread pool
+//
+
+void testThreadPool() {
+  ThreadPool pool(4);
+  CHECK(pool.size() == 4);
+
+  // Every index is visited exactly once, though the cost of the indices grows
+  // a thousandfold
+  const size_t n = 1000;
+  vector<atomic<int>> visits(n);
+  vector<int> workers(n, -1);
+  pool.parallelFor(n, [&](size_t i, size_t worker) {
+    volatile double sink = 0.0;
+    for (size_t k = 0; k < 100 * (i + 1); ++k)
+      sink = sink + 1.0;
+    visits[i]++;
+    workers[i] = int(worker);
+  });
+
+  bool once = true, in_range = true;
+  for (size_t i = 0; i < n; ++i) {
+    once = once && visits[i] == 1;
+    in_range = in_range && workers[i] >= 0 && workers[i] < 4;
+  }
+  CHECK(once);
+  CHECK(in_range);
+
+  // Fewer indices than workers and no indices
+  atomic<int> calls(0);
+  pool.parallelFor(2, [&](size_t, size_t) { calls++; });
+  pool.parallelFor(0, [&](size_t, size_t) { calls++; });
+  CHECK(calls == 2);
+
+  // Tasks submitted by tasks are finished before wait() returns
+  calls = 0;
+  for (int i = 0; i < 8; ++i)
+    pool.submit([&](size_t) {
+      calls++;
+      pool.submit([&](size_t) { calls++; });
+    });
+  pool.wait();
+  CHECK(calls == 16);
+
+  // The first exception reaches wait() once, the other tasks still run
+  calls = 0;
+  for (int i = 0; i < 16; ++i)
+    pool.submit([&calls, i](size_t) {
+      calls++;
+      if (i % 4 == 0)
+        throw runtime_error("task");
+    });
+  CHECK(throws<runtime_error>([&] { pool.wait(); }));
+  CHECK(calls == 16);
+  CHECK(!throws<exception>([&] { pool.wait(); }));
+
+  // and stops parallelFor
+  CHECK(throws<logic_error>([&] {
+    pool.parallelFor(n, [](size_t i, size_t) {
+      if (i == 10)
+        throw logic_error("index");
+    });
+  }));
+  calls = 0;
+  pool.parallelFor(n, [&](size_t, size_t) { calls++; });
+  CHECK(calls == int(n));
+}
+
+//
+// Scan pipeline
+//
+
+/*
+ * Fill scan of a wall x = distance seen by beams in range [-0.5, 0.5]
+ */
+void fillWallScan(double distance, LaserScan& scan) {
+  scan.angle_min = -0.5;
+  scan.angle_increment = 0.01;
+  scan.range_min = 0.1;
+  scan.range_max = 30.0;
+  scan.ranges.resize(101);
+  for (size_t i = 0; i < scan.ranges.size(); ++i)
+    scan.ranges[i] = distance / cos(scan.angle_min + i * scan.angle_increment);
+}
+
+/*
+ * Receive frame from pipeline, nullptr if none arrives within a few seconds
+ */
+ScanFrame* receiveFrame(ScanPipeline& pipeline) {
+  const auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+  ScanFrame* frame;
+  while (!(frame = pipeline.receive()) &&
+         chrono::steady_clock::now() < deadline)
+    this_thread::sleep_for(chrono::microseconds(100));
+  return frame;
+}
+
+/*
+ * Check if the frame holds the single wall of given sequence number
+ */
+bool isWallFrame(const ScanFrame* frame, unsigned long sequence) {
+  if (!frame || frame->sequence != sequence || frame->segments.size() != 1)
+    return false;
+
+  const Segment& s = frame->segments[0];
+  double distance = 1.0 + sequence;
+  return isNear(s.startPoint().x, distance, 1e-9) &&
+         isNear(s.endPoint().x, distance, 1e-9) &&
+         isNear(std::abs(s.endPoint().y - s.startPoint().y),
+                2.0 * distance * tan(0.5), 1e-9);
+}
+
+void testScanPipeline() {
+  ThreadPool pool(2);
+  ScanPipeline pipeline(ScanClusterer(0.1), 4, 101, &pool);
+  CHECK(throws<logic_error>([&] { pipeline.start({0, 1}); }));
+  pipeline.start();
+
+  // Frames come back in the order of submission, all of them are in use
+  unsigned long sequence = 0;
+  for (size_t i = 0; i < pipeline.frames(); ++i) {
+    ScanFrame* frame = pipeline.acquire();
+    CHECK(frame != nullptr);
+    frame->sequence = sequence++;
+    fillWallScan(1.0 + frame->sequence, frame->scan);
+    pipeline.submit(frame);
+  }
+  CHECK(pipeline.acquire() == nullptr);
+
+  for (unsigned long i = 0; i < sequence; ++i) {
+    ScanFrame* frame = receiveFrame(pipeline);
+    CHECK(isWallFrame(frame, i));
+    if (frame)
+      pipeline.release(frame);
+  }
+
+  // A frame submitted while stopped waits for the restart
+  pipeline.stop();
+  ScanFrame* frame = pipeline.acquire();
+  CHECK(frame != nullptr);
+  frame->sequence = sequence;
+  fillWallScan(1.0 + sequence, frame->scan);
+  pipeline.submit(frame);
+
+  this_thread::sleep_for(chrono::milliseconds(10));
+  CHECK(pipeline.receive() == nullptr);
+
+  pipeline.start();
+  frame = receiveFrame(pipeline);
+  CHECK(isWallFrame(frame, sequence));
+  if (frame)
+    pipeline.release(frame);
+}
+
+//
+// Figure log
+//
+
+/*
+ * Copy file with the bytes in range [first, last) replaced by given ones
+ */
+void copyPatched(const string& from, const string& to, size_t first,
+                 const vector<char>& bytes, size_t size = size_t(-1)) {
+  FILE* in = fopen(from.c_str(), "rb");
+  vector<char> data;
+  char buffer[4096];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    data.insert(data.end(), buffer, buffer + count);
+  fclose(in);
+
+  std::copy(bytes.begin(), bytes.end(), data.begin() + first);
+  data.resize(std::min(size, data.size()));
+
+  FILE* out = fopen(to.c_str(), "wb");
+  fwrite(data.data(), 1, data.size(), out);
+  fclose(out);
+}
+
+void testFigureLog() {
+  const string path = "figfit_tests.log";
+  const string corrupted = "figfit_tests_corrupted.log";
+
+  PointCloud2D points;
+  sampleArc(100, points);
+  SegmentArray segments = {Segment(Point(0.0, 0.0), Point(1.0, 2.0)),
+                           Segment(Point(-1.0, 3.0), Point(4.0, 5.0))};
+  CircleArray circles = {Circle(Point(1.0, -1.0), 2.5)};
+  LineArray lines = {Line(1.0, 2.0, -3.0)};
+
+  {
+    LogWriter writer(path);
+    writer.write(7, 0.5, points.view(), segments, circles, lines);
+    writer.write(8, 0.6, points.view(0, 10));
+    CHECK(writer.frames() == 2);
+  }
+
+  // The frames read back are the written ones
+  {
+    LogReader reader(path);
+    CHECK(reader.size() == 2);
+
+    LogFrame first = reader.frame(0);
+    CHECK(first.sequence == 7 && first.stamp == 0.5);
+    CHECK(first.points.size() == points.size());
+    bool same = true;
+    for (size_t i = 0; i < points.size(); ++i)
+      same = same && first.points.x(i) == points.x(i) &&
+             first.points.y(i) == points.y(i);
+    CHECK(same);
+
+    CHECK(first.segments.size() == 2);
+    CHECK(first.segments[1].segment().startPoint() == Point(-1.0, 3.0));
+    CHECK(first.segments[1].segment().endPoint() == Point(4.0, 5.0));
+    CHECK(first.circles.size() == 1);
+    CHECK(first.circles[0].circle().center() == circles[0].center());
+    CHECK(first.circles[0].circle().radius() == 2.5);
+    CHECK(first.lines.size() == 1);
+    CHECK(first.lines[0].A == lines[0].A());
+    CHECK(first.lines[0].C == lines[0].C());
+
+    LogFrame second = reader.frame(1);
+    CHECK(second.sequence == 8 && second.points.size() == 10);
+    CHECK(second.segments.empty() && second.circles.empty() &&
+          second.lines.empty());
+    CHECK(throws<out_of_range>([&] { reader.frame(2); }));
+  }
+
+  // A truncated file has no valid index
+  copyPatched(path, corrupted, 0, {}, 1000);
+  CHECK(throws<runtime_error>([&] { LogReader reader(corrupted); }));
+
+  // nor has a file which was not closed
+  copyPatched(path, corrupted, 8, vector<char>(8, 0));
+  CHECK(throws<runtime_error>([&] { LogReader reader(corrupted); }));
+
+  // A count of points wrapping around in the size check is rejected, the
+  // first block header follows the 24 bytes of the file header
+  uint64_t count = points.size() + (uint64_t(1) << 60);
+  vector<char> bytes(sizeof(count));
+  memcpy(bytes.data(), &count, sizeof(count));
+  copyPatched(path, corrupted, 24 + 8, bytes);
+  {
+    LogReader reader(corrupted);
+    CHECK(throws<runtime_error>([&] { reader.frame(0); }));
+    CHECK(reader.frame(1).points.size() == 10);
+  }
+
+  // and so is a block overrunning its frame
+  uint64_t size = uint64_t(1) << 40;
+  memcpy(bytes.data(), &size, sizeof(size));
+  copyPatched(path, corrupted, 24 + 16, bytes);
+  {
+    LogReader reader(corrupted);
+    CHECK(throws<runtime_error>([&] { reader.frame(0); }));
+  }
+
+  remove(path.c_str());
+  remove(corrupted.c_str());
+}
+
+//
+// Text reader
+//
+
+void writeText(const string& path, const string& text) {
+  FILE* file = fopen(path.c_str(), "wb");
+  fwrite(text.data(), 1, text.size(), file);
+  fclose(file);
+}
+
+/*
+ * Get message of the runtime error thrown by reading a file
+ */
+string readError(TextPointReader& reader, const string& path) {
+  PointCloud2D cloud;
+  try {
+    reader.read(path, cloud);
+  }
+  catch (const runtime_error& e) {
+    return e.what();
+  }
+  return "";
+}
+
+void testTextReader() {
+  const string path = "figfit_tests.txt";
+  PointCloud2D cloud;
+
+  // CSV with a header, comments, blank lines and CRLF line ends
+  TextFormat csv;
+  csv.header_lines = 1;
+  writeText(path, "x,y,z\r\n"
+                  "# comment\r\n"
+                  "1.5,2.5,3\r\n"
+                  "\r\n"
+                  "-4;+5e1;6 # trailing comment\r\n"
+                  "  7 ,\t8\r\n");
+  TextPointReader(csv).read(path, cloud);
+  CHECK(cloud.size() == 3);
+  CHECK(cloud.point(0) == Point(1.5, 2.5));
+  CHECK(cloud.point(1) == Point(-4.0, 50.0));
+  CHECK(cloud.point(2) == Point(7.0, 8.0));
+
+  // XYZ with swapped columns and a skipped column which is not a number,
+  // without a line end at the end of the file
+  TextFormat xyz;
+  xyz.x_column = 2;
+  xyz.y_column = 0;
+  xyz.comment = '%';
+  writeText(path, "10 label 30\n"
+                  "% comment\n"
+                  "\t-1\tx\t-3");
+  TextPointReader(xyz).read(path, cloud);
+  CHECK(cloud.size() == 2);
+  CHECK(cloud.point(0) == Point(30.0, 10.0));
+  CHECK(cloud.point(1) == Point(-3.0, -1.0));
+
+  // Many lines split into chunks by a pool give the same points
+  string text = "header\n";
+  vector<Point> expected;
+  for (size_t i = 0; i < 2000; ++i) {
+    if (i % 7 == 0)
+      text += "# comment " + to_string(i) + "\n";
+    if (i % 11 == 0)
+      text += "\n";
+    expected.push_back(Point(i, 0.5 * i));
+    text += to_string(i) + ", " + to_string(0.5 * i) + "\n";
+  }
+  writeText(path, text);
+
+  ThreadPool pool(3);
+  TextFormat one_header;
+  one_header.header_lines = 1;
+  TextPointReader sequential(one_header), parallel(one_header, &pool);
+  PointCloud2D parallel_cloud;
+  sequential.read(path, cloud);
+  parallel.read(path, parallel_cloud);
+
+  bool same = cloud.size() == expected.size() &&
+              parallel_cloud.size() == expected.size();
+  for (size_t i = 0; same && i < expected.size(); ++i)
+    same = cloud.point(i) == expected[i] &&
+           parallel_cloud.point(i) == expected[i];
+  CHECK(same);
+
+  // The first malformed line is reported with its number, counted from one
+  // including the header, whichever chunk it falls into
+  size_t newlines = 0, position = 0;
+  while (newlines < 1500)
+    newlines += text[position++] == '\n';
+  writeText(path, text.substr(0, position) + "1.0, abc\n" +
+                  text.substr(position) + "2.0\n");
+  CHECK(readError(sequential, path).find("at line 1501") != string::npos);
+  CHECK(readError(parallel, path).find("at line 1501") != string::npos);
+
+  // Too few fields
+  writeText(path, "1.0 2.0\n3.0\n");
+  TextPointReader plain;
+  CHECK(readError(plain, path).find("at line 2") != string::npos);
+
+  remove(path.c_str());
+}
+
+//
+// Exceptions
+//
+
+void testExceptions() {
+  PointCloud2D single;
+  single.push_back(1.0, 1.0);
+  FigureFitter empty, one(single);
+  Point p;
+  Line l;
+  Segment s;
+  Circle c;
+  vector<Line> lines;
+  const vector<Moments> moments_of_one = {one.findMoments(),
+                                          one.findMoments()};
+
+  // Too few points are misuse for the fits of points and lines
+  CHECK(throws<logic_error>([&] { empty.fitPoint(p); }));
+  CHECK(throws<logic_error>([&] { one.fitLine(l); }));
+  CHECK(throws<logic_error>([&] { one.fitSegment(s); }));
+  CHECK(throws<logic_error>([&] { FigureFitter::fitLine(Moments(), l); }));
+  CHECK(throws<logic_error>([&] {
+    FigureFitter::fitParallelLines({one.findMoments(), empty.findMoments()},
+                                   lines); }));
+  CHECK(throws<logic_error>([&] {
+    FigureFitter::fitPerpendicularLines(one, empty, l, l); }));
+
+  // and a failure of the data for the other fits
+  CHECK(throws<runtime_error>([&] { one.fitCircle(c); }));
+  CHECK(!throws<logic_error>([&] { one.fitCircle(c); }));
+  CHECK(throws<runtime_error>([&] {
+    FigureFitter::fitManhattanLines(moments_of_one, lines); }));
+  CHECK(!throws<logic_error>([&] {
+    FigureFitter::fitManhattanLines(moments_of_one, lines); }));
+
+  // Identical points give the minimum norm line, but no segment
+  PointCloud2D same;
+  same.push_back(1.0, 2.0);
+  same.push_back(1.0, 2.0);
+  FigureFitter twice(same);
+  CHECK(!throws<exception>([&] { twice.fitLine(l); }));
+  CHECK(isNear(l.distanceTo(Point(1.0, 2.0)), 0.0));
+  CHECK(throws<logic_error>([&] { twice.fitSegment(s); }));
+  CHECK(throws<logic_error>([&] {
+    twice.fitSegment(s, SegmentExtent::FirstLast); }));
+}
+
+//
+// Main
+//
+
+int main(int argc, char** argv) {
+  const vector<pair<string, function<void()>>> tests = {
+    {"segment", testSegment},
+    {"circle_of_radius", testCircleOfRadius},
+    {"ellipse", testEllipse},
+    {"rectangle", testRectangle},
+    {"convex_hull", testConvexHull},
+    {"enclosing_circle", testEnclosingCircle},
+    {"polyline_simplifier", testPolylineSimplifier},
+    {"moments", testMoments},
+    {"parallel_fitter", testParallelFitter},
+    {"spsc_queue", testSpscQueue},
+    {"thread_pool", testThreadPool},
+    {"scan_pipeline", testScanPipeline},
+    {"figure_log", testFigureLog},
+    {"text_reader", testTextReader},
+    {"exceptions", testExceptions}
+  };
+
+  for (const auto& test : tests) {
+    if (argc > 1 && test.first != argv[1])
+      continue;
+
+    size_t before = failures;
+    test.second();
+    cerr << test.first << ": " << (failures == before ? "ok" : "FAILED")
+         << "\n";
+  }
+
+  return failures > 0 ? 1 : 0;
+}
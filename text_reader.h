@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../mapped_file.h"
+#include "../point_cloud.h"
+#include "../thread_pool.h"
+
+namespace figfit
+{
+
+/**
+ * @struct TextFormat text_reader.h
+ *
+ * @brief Layout of a text point file
+ *
+ * Fields are separated by any mix of spaces, tabs, commas and semicolons, so
+ * the same format reads CSV and XYZ files. Everything from the comment
+ * character to the end of a line is ignored and lines without fields are
+ * skipped.
+ */
+struct TextFormat
+{
+  size_t x_column = 0;        /**< @brief Field of x coordinate (from zero) */
+  size_t y_column = 1;        /**< @brief Field of y coordinate (from zero) */
+  char comment = '#';         /**< @brief Character starting a comment */
+  size_t header_lines = 0;    /**< @brief Lines skipped at the beginning */
+};
+
+/**
+ * @class TextPointReader text_reader.h
+ *
+ * @brief Parallel reader of text point files
+ *
+ * Maps the file into memory and splits it into chunks at line boundaries.
+ * The first pass counts the data lines of every chunk, which gives the exact
+ * size of the point cloud and the position of every chunk in it. The second
+ * pass parses the chunks with std::from_chars straight into the coordinate
+ * arrays of the cloud, with no intermediate strings or copies. Both passes
+ * run on the optional ThreadPool.
+ */
+class TextPointReader
+{
+public:
+
+  /**
+   * @brief Construction with given format (default)
+   *
+   * @param format is the layout of the files
+   * @param pool is an optional pool for parsing in parallel, it must outlive
+   * the reader
+   */
+  explicit TextPointReader(const TextFormat& format = TextFormat(),
+                           ThreadPool* pool = nullptr) :
+    format_(format),
+    pool_(pool)
+  {}
+
+  /**
+   * @brief Read points of a file
+   *
+   * @param path is the path of the file
+   * @param cloud is a placeholder for the points
+   *
+   * @throw std::runtime_error if the file cannot be read, or a data line has
+   * too few fields or an invalid number
+   */
+  void read(const std::string& path, PointCloud2D& cloud) {
+    MappedFile file(path);
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    for (size_t i = 0; i < format_.header_lines && begin < end; ++i)
+      begin = nextLine(begin, end);
+
+    // Chunks start at line boundaries
+    const size_t parts = pool_ ? 4 * pool_->size() : 1;
+    chunks_.assign(parts, Chunk());
+    for (size_t i = 0; i < parts; ++i) {
+      const char* first = (i == 0) ? begin :
+                          begin + (end - begin) / parts * i;
+      if (i != 0 && first > begin && first[-1] != '\n')
+        first = nextLine(first, end);
+      chunks_[i].first = std::max(first, i ? chunks_[i - 1].first : begin);
+    }
+    for (size_t i = 0; i < parts; ++i)
+      chunks_[i].last = (i + 1 < parts) ? chunks_[i + 1].first : end;
+
+    run(parts, [this](size_t i) { count(chunks_[i]); });
+
+    size_t points = 0, lines = format_.header_lines;
+    for (Chunk& chunk : chunks_) {
+      chunk.point = points;
+      chunk.line = lines;
+      points += chunk.points;
+      lines += chunk.lines;
+    }
+
+    cloud.resize(points);
+    double* x = cloud.xData();
+    double* y = cloud.yData();
+
+    run(parts, [this, x, y](size_t i) { parse(chunks_[i], x, y); });
+
+    for (const Chunk& chunk : chunks_)
+      if (chunk.error != 0)
+        throw std::runtime_error("Error while parsing " + path + " at line " +
+                                 std::to_string(chunk.error));
+  }
+
+private:
+
+  /**
+   * @struct Chunk
+   *
+   * @brief Part of a file parsed by one task
+   */
+  struct Chunk
+  {
+    const char* first = nullptr;  /**< @brief First character */
+    const char* last = nullptr;   /**< @brief Character past the chunk */
+    size_t lines = 0;             /**< @brief Number of lines */
+    size_t points = 0;            /**< @brief Number of data lines */
+    size_t line = 0;              /**< @brief Lines before the chunk */
+    size_t point = 0;             /**< @brief Points before the chunk */
+    size_t error = 0;             /**< @brief First invalid line or zero */
+  };
+
+  template <typename Function>
+  void run(size_t parts, const Function& function) {
+    if (pool_)
+      pool_->parallelFor(parts, [&function](size_t i, size_t) {
+        function(i);
+      });
+    else
+      for (size_t i = 0; i < parts; ++i)
+        function(i);
+  }
+
+  static const char* nextLine(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    return eol ? eol + 1 : end;
+  }
+
+  static bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+  }
+
+  /**
+   * @brief Get end of the data of a line, at the comment or the line end
+   */
+  const char* findDataEnd(const char* p, const char* line_end) const {
+    const char* comment = static_cast<const char*>(
+                            memchr(p, format_.comment, line_end - p));
+    return comment ? comment : line_end;
+  }
+
+  /**
+   * @brief Check if a line contains any field
+   */
+  bool hasData(const char* p, const char* data_end) const {
+    while (p < data_end && isSeparator(*p))
+      p++;
+    return p < data_end && *p != '\n';
+  }
+
+  /**
+   * @brief First pass: count lines and data lines of a chunk
+   */
+  void count(Chunk& chunk) const {
+    for (const char* p = chunk.first; p < chunk.last; ) {
+      const char* next = nextLine(p, chunk.last);
+      chunk.lines++;
+      if (hasData(p, findDataEnd(p, next)))
+        chunk.points++;
+      p = next;
+    }
+  }
+
+  /**
+   * @brief Second pass: parse data lines of a chunk into the arrays
+   */
+  void parse(Chunk& chunk, double* x, double* y) const {
+    size_t point = chunk.point;
+    size_t line = chunk.line;
+    const size_t columns = std::max(format_.x_column, format_.y_column) + 1;
+
+    for (const char* p = chunk.first; p < chunk.last; ) {
+      const char* next = nextLine(p, chunk.last);
+      const char* data_end = findDataEnd(p, next);
+      line++;
+
+      if (!hasData(p, data_end)) {
+        p = next;
+        continue;
+      }
+
+      size_t found = 0;
+      for (size_t column = 0; column < columns; ++column) {
+        while (p < data_end && isSeparator(*p))
+          p++;
+        if (p == data_end || *p == '\n')
+          break;
+
+        const char* field = p;
+        while (p < data_end && !isSeparator(*p) && *p != '\n')
+          p++;
+
+        if (column != format_.x_column && column != format_.y_column)
+          continue;
+
+        if (*field == '+')
+          field++;
+
+        double value;
+        std::from_chars_result result = std::from_chars(field, p, value);
+        if (result.ec != std::errc() || result.ptr != p)
+          break;
+
+        if (column == format_.x_column)
+          x[point] = value;
+        if (column == format_.y_column)
+          y[point] = value;
+        found = column + 1;
+      }
+
+      if (found != columns) {
+        chunk.error = line;
+        return;
+      }
+
+      point++;
+      p = next;
+    }
+  }
+
+  TextFormat format_;           /**< @brief Layout of the files */
+  ThreadPool* pool_;            /**< @brief Optional pool of parsing tasks */
+  std::vector<Chunk> chunks_;   /**< @brief Chunks of the current file */
+};
+
+} // end namespace figfit
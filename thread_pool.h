@@ -0,0 +1,386 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace figfit
+{
+
+/**
+ * @brief Pin thread to given core (Linux only)
+ *
+ * Core numbers beyond the number of hardware threads wrap around. Failures
+ * are ignored, since pinning only tunes the performance.
+ *
+ * @param thread is the thread to be pinned
+ * @param core is the index of the core
+ */
+inline void pinToCore(std::thread& thread, size_t core) {
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(core % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpus);
+#else
+  (void)thread;
+  (void)core;
+#endif
+}
+
+/**
+ * @class ThreadPool thread_pool.h
+ *
+ * @brief Work-stealing pool of worker threads
+ *
+ * Every worker owns a deque of tasks. A worker takes tasks from the back of
+ * its own deque and, when it runs dry, steals from the front of the deques of
+ * the other workers. Tasks submitted from outside of the pool are dealt to
+ * the workers in turns, tasks submitted by a running task go to the deque of
+ * its worker. This keeps the cores busy for batches of tasks of very uneven
+ * cost, e.g. fits of clusters of a dense scan.
+ *
+ * Each task gets the index of the worker running it, in range [0, size()),
+ * which lets it use per-worker workspaces without locking (see PerWorker).
+ * Workers can optionally be pinned to consecutive cores. The deques keep
+ * their slots between tasks, so queuing a task whose function fits into the
+ * small buffer of std::function (e.g. a lambda capturing a single reference)
+ * does not allocate memory once the deques have grown to the largest batch.
+ */
+class ThreadPool
+{
+public:
+
+  /**
+   * @brief Task receiving the index of the worker running it
+   */
+  typedef std::function<void(size_t)> Task;
+
+  /**
+   * @brief Construction with given number of workers (default)
+   *
+   * @param threads is the number of workers, zero stands for the number of
+   * hardware threads
+   * @param pin if true, i-th worker is pinned to i-th core (Linux only)
+   */
+  explicit ThreadPool(size_t threads = 0, bool pin = false) :
+    queued_(0),
+    pending_(0),
+    next_(0),
+    stop_(false)
+  {
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < threads; ++i)
+      queues_.emplace_back(new WorkQueue());
+
+    for (size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back(&ThreadPool::run, this, i);
+      if (pin)
+        pinToCore(workers_.back(), i);
+    }
+  }
+
+  ThreadPool(const ThreadPool& rhs) = delete;
+  ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+  /**
+   * @brief Destruction (finishes queued tasks and joins the workers)
+   */
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+
+    for (std::thread& t : workers_)
+      t.join();
+  }
+
+  /**
+   * @brief Submit a task
+   *
+   * @param task is a function called with the index of the worker
+   */
+  void submit(Task task) {
+    pending_++;
+
+    size_t target = (current().pool == this) ?
+                    current().worker : next_++ % queues_.size();
+
+    // The count changes together with the deque, so it never runs below the
+    // number of queued tasks, and under the guard of sleeping, so a worker
+    // going to sleep cannot miss it
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::lock_guard<std::mutex> queue_lock(queues_[target]->mutex);
+      queues_[target]->pushBack(task);
+      queued_++;
+    }
+    wake_.notify_one();
+  }
+
+  /**
+   * @brief Wait until all of the submitted tasks are finished
+   *
+   * Must not be called from a task of this pool.
+   *
+   * @throw the first exception thrown by any of the tasks
+   */
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+
+    if (error_) {
+      std::exception_ptr error = error_;
+      error_ = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  /**
+   * @brief Call function for indices [0, n) in parallel and wait
+   *
+   * Submits one task per worker and the tasks take the indices one by one
+   * from a shared counter, so indices of uneven cost are balanced without a
+   * task per index. The tasks capture a single reference, hence the call does
+   * not allocate memory. Must not be called from a task of this pool.
+   *
+   * @param n is the number of indices
+   * @param function is called as function(index, worker)
+   *
+   * @throw the first exception thrown by function, the task which threw it
+   * takes no further indices
+   */
+  template <typename Function>
+  void parallelFor(size_t n, const Function& function) {
+    std::atomic<size_t> next(0);
+    const auto loop = [&function, &next, n](size_t worker) {
+      for (size_t i = next++; i < n; i = next++)
+        function(i, worker);
+    };
+
+    const size_t tasks = std::min(n, size());
+    for (size_t i = 0; i < tasks; ++i)
+      submit([&loop](size_t worker) { loop(worker); });
+
+    wait();
+  }
+
+  /**
+   * @brief Get number of workers
+   */
+  size_t size() const {
+    return workers_.size();
+  }
+
+private:
+
+  /**
+   * @struct WorkQueue
+   *
+   * @brief Deque of tasks of a single worker
+   *
+   * Ring buffer of task slots, which grows only when it is full. Unlike
+   * std::deque, it does not free and reallocate its blocks as tasks come and
+   * go.
+   */
+  struct WorkQueue
+  {
+    std::mutex mutex;         /**< @brief Guard of the deque */
+    std::vector<Task> slots;  /**< @brief Ring buffer of tasks */
+    size_t front;             /**< @brief Slot of the front task */
+    size_t size;              /**< @brief Number of queued tasks */
+
+    WorkQueue() :
+      slots(16),
+      front(0),
+      size(0)
+    {}
+
+    /**
+     * @brief Push task to the back, doubling the slots if they are full
+     */
+    void pushBack(Task& task) {
+      if (size == slots.size()) {
+        std::vector<Task> grown(2 * slots.size());
+        for (size_t i = 0; i < size; ++i)
+          grown[i] = std::move(slots[(front + i) % slots.size()]);
+        slots.swap(grown);
+        front = 0;
+      }
+
+      slots[(front + size++) % slots.size()] = std::move(task);
+    }
+
+    /**
+     * @brief Pop task from the back (the deque must not be empty)
+     */
+    void popBack(Task& task) {
+      task = std::move(slots[(front + --size) % slots.size()]);
+    }
+
+    /**
+     * @brief Pop task from the front (the deque must not be empty)
+     */
+    void popFront(Task& task) {
+      task = std::move(slots[front]);
+      front = (front + 1) % slots.size();
+      size--;
+    }
+  };
+
+  /**
+   * @struct Worker
+   *
+   * @brief Identity of the worker running on the current thread
+   */
+  struct Worker
+  {
+    const ThreadPool* pool;   /**< @brief Pool of the worker or nullptr */
+    size_t worker;            /**< @brief Index of the worker */
+  };
+
+  static Worker& current() {
+    static thread_local Worker worker = {nullptr, 0};
+    return worker;
+  }
+
+  /**
+   * @brief Take task from the own deque or steal one from the others
+   *
+   * The count of queued tasks is decremented under the lock of the deque.
+   */
+  bool take(size_t worker, Task& task) {
+    {
+      WorkQueue& own = *queues_[worker];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (own.size > 0) {
+        own.popBack(task);
+        queued_--;
+        return true;
+      }
+    }
+
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      WorkQueue& other = *queues_[(worker + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(other.mutex);
+      if (other.size > 0) {
+        other.popFront(task);
+        queued_--;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * @brief Loop of a worker thread
+   */
+  void run(size_t worker) {
+    current() = Worker{this, worker};
+    Task task;
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (queued_ == 0)
+          return;
+      }
+
+      // Another worker took the task first, sleep unless tasks are left
+      if (!take(worker, task))
+        continue;
+
+      try {
+        task(worker);
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_)
+          error_ = std::current_exception();
+      }
+      task = nullptr;
+
+      if (--pending_ == 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_all();
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;  /**< @brief Deques */
+  std::vector<std::thread> workers_;    /**< @brief Worker threads */
+
+  std::mutex mutex_;                    /**< @brief Guard of sleeping */
+  std::condition_variable wake_;        /**< @brief Signal of new tasks */
+  std::condition_variable done_;        /**< @brief Signal of finished tasks */
+  std::atomic<size_t> queued_;          /**< @brief Tasks not yet taken */
+  std::atomic<size_t> pending_;         /**< @brief Tasks not yet finished */
+  std::atomic<size_t> next_;            /**< @brief Turn of external tasks */
+  std::exception_ptr error_;            /**< @brief First error of tasks */
+  bool stop_;                           /**< @brief Flag of destruction */
+};
+
+/**
+ * @class PerWorker thread_pool.h
+ *
+ * @brief Array of workspaces, one per worker of a ThreadPool
+ *
+ * Workspaces are padded to separate cache lines, so workers writing to their
+ * own workspaces do not contend with each other.
+ */
+template <typename T>
+class PerWorker
+{
+public:
+
+  /**
+   * @brief Construction of workspaces for given pool
+   *
+   * @param pool is the pool the workspaces are used with
+   * @param value is the initial value of every workspace
+   */
+  explicit PerWorker(const ThreadPool& pool, const T& value = T()) :
+    slots_(pool.size(), Slot{value})
+  {}
+
+  /**
+   * @brief Get workspace of given worker
+   */
+  T& operator[](size_t worker) {
+    return slots_[worker].value;
+  }
+
+  /**
+   * @brief Get number of workspaces
+   */
+  size_t size() const {
+    return slots_.size();
+  }
+
+private:
+
+  struct alignas(64) Slot
+  {
+    T value;
+  };
+
+  std::vector<Slot> slots_;   /**< @brief Padded workspaces */
+};
+
+} // end namespace figfit
@@ -0,0 +1,187 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../clustering.h"
+#include "../figure_fitter.h"
+#include "../figure_log.h"
+#include "../thread_pool.h"
+
+using namespace std;
+using namespace figfit;
+
+/*
+ * Replays a recorded log through the cluster -> fit stages on all cores and
+ * writes the fitted segments of every frame, in the original order, to
+ * another log. Frames are processed in windows: while the workers process one
+ * window, the main thread writes the results of the previous one.
+ */
+
+struct Options
+{
+  string input;
+  string output;
+  size_t threads = 0;
+  size_t window = 0;
+  double distance = 0.1;
+  double ratio = 0.0;
+  size_t min_points = 3;
+  SegmentExtent extent = SegmentExtent::MinMax;
+  bool figures_only = false;
+};
+
+struct FrameResult
+{
+  ClusterArray clusters;
+  SegmentArray segments;
+  FitWorkspace workspace;
+};
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " INPUT OUTPUT [options]\n"
+       << "  --threads N        number of workers (default: all cores)\n"
+       << "  --window N         frames processed at once (default: 4 per "
+          "worker)\n"
+       << "  --distance D       clustering distance threshold (default: 0.1)\n"
+       << "  --ratio R          clustering threshold per unit range "
+          "(default: 0)\n"
+       << "  --min-points N     minimal points of a cluster (default: 3)\n"
+       << "  --extent E         first-last, min-max or trimmed (default: "
+          "min-max)\n"
+       << "  --figures-only     do not copy points to the output\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+  vector<string> positional;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    bool has_value = (i + 1 < argc);
+
+    if (arg == "--figures-only")
+      options.figures_only = true;
+    else if (arg == "--threads" && has_value)
+      options.threads = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--window" && has_value)
+      options.window = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--distance" && has_value)
+      options.distance = strtod(argv[++i], nullptr);
+    else if (arg == "--ratio" && has_value)
+      options.ratio = strtod(argv[++i], nullptr);
+    else if (arg == "--min-points" && has_value)
+      options.min_points = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--extent" && has_value) {
+      string extent = argv[++i];
+      if (extent == "first-last")
+        options.extent = SegmentExtent::FirstLast;
+      else if (extent == "min-max")
+        options.extent = SegmentExtent::MinMax;
+      else if (extent == "trimmed")
+        options.extent = SegmentExtent::Trimmed;
+      else
+        return false;
+    }
+    else if (arg.compare(0, 2, "--") == 0)
+      return false;
+    else
+      positional.push_back(arg);
+  }
+
+  if (positional.size() != 2)
+    return false;
+
+  options.input = positional[0];
+  options.output = positional[1];
+  return true;
+}
+
+void processFrame(const LogFrame& frame, const ScanClusterer& clusterer,
+                  SegmentExtent extent, FrameResult& result) {
+  clusterer.cluster(frame.points, result.clusters);
+  result.segments.clear();
+
+  for (const Cluster& cluster : result.clusters) {
+    FigureFitter fitter(cluster.view(frame.points), result.workspace);
+    Segment segment;
+
+    // Degenerate clusters are dropped
+    if (fitter.tryFitSegment(segment, extent) == FitStatus::Ok)
+      result.segments.push_back(segment);
+  }
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  try {
+    LogReader reader(options.input);
+    LogWriter writer(options.output);
+    ThreadPool pool(options.threads);
+    ScanClusterer clusterer(options.distance, options.ratio,
+                            options.min_points);
+
+    const size_t frames = reader.size();
+    const size_t window = options.window ? options.window : 4 * pool.size();
+
+    // Two windows of results: one being processed, one being written
+    vector<FrameResult> results[2];
+    results[0].resize(window);
+    results[1].resize(window);
+
+    auto submitWindow = [&](size_t first, vector<FrameResult>& window_results) {
+      for (size_t i = first; i < min(first + window, frames); ++i) {
+        FrameResult* result = &window_results[i - first];
+        pool.submit([&, i, result](size_t) {
+          processFrame(reader.frame(i), clusterer, options.extent, *result);
+        });
+      }
+    };
+
+    size_t points = 0;
+    size_t segments = 0;
+    auto start = chrono::steady_clock::now();
+
+    submitWindow(0, results[0]);
+    for (size_t first = 0, w = 0; first < frames; first += window, w ^= 1) {
+      pool.wait();
+      submitWindow(first + window, results[w ^ 1]);
+
+      for (size_t i = first; i < min(first + window, frames); ++i) {
+        LogFrame frame = reader.frame(i);
+        const FrameResult& result = results[w][i - first];
+
+        writer.write(frame.sequence, frame.stamp,
+                     options.figures_only ? PointCloudView() : frame.points,
+                     result.segments);
+
+        points += frame.points.size();
+        segments += result.segments.size();
+      }
+    }
+    writer.close();
+
+    double seconds = chrono::duration<double>(
+                       chrono::steady_clock::now() - start).count();
+
+    cout << "frames:   " << frames << "\n"
+         << "points:   " << points << "\n"
+         << "segments: " << segments << "\n"
+         << "threads:  " << pool.size() << "\n"
+         << "time:     " << seconds << " s\n"
+         << "frames/s: " << frames / seconds << "\n"
+         << "points/s: " << points / seconds << "\n";
+  }
+  catch (const exception& e) {
+    cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "../kernels.h"
+#include "../point_cloud.h"
+#include "../figures/line.h"
+#include "../figures/segment.h"
+#include "../figures/circle.h"
+#include "../figures/arc.h"
+#include "../figures/ellipse.h"
+#include "../figures/rectangle.h"
+
+namespace figfit
+{
+
+/**
+ * @class Transform2D transform.h
+ *
+ * @brief Rigid transformation of the plane (SE(2))
+ *
+ * The transformation rotates by angle theta counter-clockwise and then
+ * translates by (x, y), i.e. p' = R(theta) * p + t. The cosine and sine of the
+ * angle are computed once at construction, hence transforming a point costs
+ * four multiplications and four additions. Whole point clouds and arrays of
+ * figures are transformed in batch, e.g. from the sensor frame to the
+ * odometry frame.
+ */
+class Transform2D
+{
+public:
+
+  //
+  // Constructors
+  //
+
+  /**
+   * @brief Construction from translation and angle (default)
+   *
+   * Note that the default transformation is the identity.
+   *
+   * @param x is the translation along abscissa
+   * @param y is the translation along ordinate
+   * @param theta is the angle of rotation in radians
+   */
+  Transform2D(double x = 0.0, double y = 0.0, double theta = 0.0) :
+    x_(x), y_(y), theta_(theta), cos_(cos(theta)), sin_(sin(theta))
+  {}
+
+  //
+  // Transformation methods
+  //
+
+  /**
+   * @brief Get inverse transformation
+   */
+  Transform2D inverse() const {
+    return Transform2D(-( cos_ * x_ + sin_ * y_),
+                       -(-sin_ * x_ + cos_ * y_),
+                       -theta_, cos_, -sin_);
+  }
+
+  /**
+   * @brief Compose two transformations
+   *
+   * @return transformation applying rhs first and lhs second
+   */
+  friend Transform2D operator*(const Transform2D& lhs, const Transform2D& rhs) {
+    return Transform2D(lhs.cos_ * rhs.x_ - lhs.sin_ * rhs.y_ + lhs.x_,
+                       lhs.sin_ * rhs.x_ + lhs.cos_ * rhs.y_ + lhs.y_,
+                       lhs.theta_ + rhs.theta_,
+                       lhs.cos_ * rhs.cos_ - lhs.sin_ * rhs.sin_,
+                       lhs.sin_ * rhs.cos_ + lhs.cos_ * rhs.sin_);
+  }
+
+  /**
+   * @brief Transform vector (rotation only)
+   */
+  Vec rotate(const Vec& v) const {
+    return Vec(cos_ * v.x - sin_ * v.y, sin_ * v.x + cos_ * v.y);
+  }
+
+  /**
+   * @brief Transform point
+   */
+  Point apply(const Point& p) const {
+    return Point(cos_ * p.x - sin_ * p.y + x_, sin_ * p.x + cos_ * p.y + y_);
+  }
+
+  /**
+   * @brief Transform point cloud in place
+   *
+   * @param cloud is the point cloud to be transformed
+   */
+  void apply(PointCloud2D& cloud) const {
+    apply(cloud.xData(), cloud.yData(), cloud.size(),
+          cloud.xData(), cloud.yData());
+  }
+
+  /**
+   * @brief Transform point cloud out of place
+   *
+   * The storage of the output cloud is reused if its capacity suffices.
+   *
+   * @param input is the view of points to be transformed
+   * @param output is a placeholder for the transformed points
+   */
+  void apply(const PointCloudView& input, PointCloud2D& output) const {
+    output.resize(input.size());
+    apply(input.xData(), input.yData(), input.size(),
+          output.xData(), output.yData());
+  }
+
+  /**
+   * @brief Transform coordinate arrays
+   *
+   * Runs the vectorized kernel of kernels::active() over separate arrays of
+   * coordinates. The output arrays may be the same as the input arrays.
+   *
+   * @param x_in is the array of input x coordinates
+   * @param y_in is the array of input y coordinates
+   * @param n is the number of points
+   * @param x_out is the array of output x coordinates
+   * @param y_out is the array of output y coordinates
+   */
+  void apply(const double* x_in, const double* y_in, size_t n,
+             double* x_out, double* y_out) const {
+    kernels::active().transform(x_in, y_in, n, cos_, sin_, x_, y_,
+                                x_out, y_out);
+  }
+
+  /**
+   * @brief Transform line
+   */
+  Line apply(const Line& l) const {
+    Vec normal = rotate(Vec(l.A(), l.B()));
+    return Line(normal.x, normal.y, l.C() - normal.x * x_ - normal.y * y_);
+  }
+
+  /**
+   * @brief Transform segment
+   */
+  Segment apply(const Segment& s) const {
+    return Segment(apply(s.startPoint()), apply(s.endPoint()));
+  }
+
+  /**
+   * @brief Transform circle
+   */
+  Circle apply(const Circle& c) const {
+    return Circle(apply(c.center()), c.radius());
+  }
+
+  /**
+   * @brief Transform arc
+   */
+  Arc apply(const Arc& a) const {
+    return Arc(apply(a.center()), a.radius(),
+               a.startAngle() + theta_, a.endAngle() + theta_);
+  }
+
+  /**
+   * @brief Transform ellipse
+   */
+  Ellipse apply(const Ellipse& e) const {
+    return Ellipse(apply(e.center()), e.semiMajorAxis(), e.semiMinorAxis(),
+                   e.angle() + theta_);
+  }
+
+  /**
+   * @brief Transform rectangle
+   */
+  Rectangle apply(const Rectangle& r) const {
+    return Rectangle(apply(r.center()), r.length(), r.width(),
+                     r.angle() + theta_);
+  }
+
+  /**
+   * @brief Transform array of figures in place
+   *
+   * @param figures is the array of figures, any vector of figures, e.g.
+   * SegmentArray or pmr::SegmentArray
+   */
+  template <typename FigureType, typename Allocator>
+  void apply(std::vector<FigureType, Allocator>& figures) const {
+    for (FigureType& f : figures)
+      f = apply(f);
+  }
+
+  /**
+   * @brief Transform array of figures out of place
+   *
+   * @param input is the array of figures to be transformed
+   * @param output is a placeholder for the transformed figures, its allocator
+   * may differ from the one of the input, e.g. pmr::SegmentArray taking
+   * memory from a FrameArena
+   */
+  template <typename FigureType, typename InputAllocator,
+            typename OutputAllocator>
+  void apply(const std::vector<FigureType, InputAllocator>& input,
+             std::vector<FigureType, OutputAllocator>& output) const {
+    output.clear();
+    output.reserve(input.size());
+    for (const FigureType& f : input)
+      output.push_back(apply(f));
+  }
+
+  //
+  // Getter methods
+  //
+
+  /**
+   * @brief Get translation along abscissa
+   */
+  double x() const {
+    return x_;
+  }
+
+  /**
+   * @brief Get translation along ordinate
+   */
+  double y() const {
+    return y_;
+  }
+
+  /**
+   * @brief Get angle of rotation
+   */
+  double theta() const {
+    return theta_;
+  }
+
+  //
+  // Ostream operator
+  //
+
+  friend std::ostream& operator<<(std::ostream& out, const Transform2D& t) {
+    out << "[" << t.x_ << ", " << t.y_ << ", " << t.theta_ << "]";
+    return out;
+  }
+
+private:
+
+  /**
+   * @brief Construction from precomputed cosine and sine
+   */
+  Transform2D(double x, double y, double theta, double c, double s) :
+    x_(x), y_(y), theta_(theta), cos_(c), sin_(s)
+  {}
+
+  double x_;      /**< @brief Translation along abscissa */
+  double y_;      /**< @brief Translation along ordinate */
+  double theta_;  /**< @brief Angle of rotation */
+  double cos_;    /**< @brief Cosine of the angle */
+  double sin_;    /**< @brief Sine of the angle */
+};
+
+} // end namespace figfit
@@ -0,0 +1,489 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../laser_scan.h"
+#include "../point_cloud.h"
+#include "../figures/segment.h"
+#include "../figures/circle.h"
+#include "../figures/arc.h"
+#include "../figures/ellipse.h"
+#include "../figures/rectangle.h"
+
+namespace figfit
+{
+
+/**
+ * @struct NoiseModel workload_generator.h
+ *
+ * @brief Noise applied to generated points and ranges
+ *
+ * Every generated point (or beam) is first dropped with the dropout rate,
+ * then replaced by an outlier with the outlier rate and otherwise perturbed by
+ * Gaussian noise, whose standard deviation grows linearly with the distance
+ * from the sensor. Points sampled from figures are perturbed in both
+ * coordinates, ranges of scans only along the beam.
+ */
+struct NoiseModel
+{
+  double sigma = 0.0;           /**< @brief Standard deviation at zero range */
+  double range_sigma = 0.0;     /**< @brief Deviation added per unit range */
+  double outlier_rate = 0.0;    /**< @brief Probability of an outlier */
+  double outlier_spread = 1.0;  /**< @brief Maximal offset of an outlier */
+  double dropout_rate = 0.0;    /**< @brief Probability of a missing point */
+  Point sensor;                 /**< @brief Origin of range dependence */
+
+  /**
+   * @brief Construction of Gaussian noise (default)
+   *
+   * @param sigma is the standard deviation of the noise
+   */
+  NoiseModel(double sigma = 0.0) :
+    sigma(sigma)
+  {}
+};
+
+/**
+ * @struct Scene workload_generator.h
+ *
+ * @brief Set of walls and round obstacles for simulated scans
+ */
+struct Scene
+{
+  SegmentArray walls;     /**< @brief Walls of the scene */
+  CircleArray pillars;    /**< @brief Round obstacles of the scene */
+
+  /**
+   * @brief Add walls of an axis-aligned box
+   */
+  void addBox(double x0, double y0, double x1, double y1) {
+    walls.emplace_back(Point(x0, y0), Point(x1, y0));
+    walls.emplace_back(Point(x1, y0), Point(x1, y1));
+    walls.emplace_back(Point(x1, y1), Point(x0, y1));
+    walls.emplace_back(Point(x0, y1), Point(x0, y0));
+  }
+
+  /**
+   * @brief Find distance along a ray to the nearest obstacle
+   *
+   * @param origin is the origin of the ray
+   * @param direction is the unit direction of the ray
+   * @param max_range is the maximal range of the ray
+   *
+   * @return distance to the nearest obstacle or infinity if there is none
+   * within the maximal range
+   */
+  double castRay(const Point& origin, const Vec& direction,
+                 double max_range) const {
+    double nearest = max_range;
+
+    for (const Segment& wall : walls) {
+      Vec edge = wall.endPoint() - wall.startPoint();
+      Vec offset = wall.startPoint() - origin;
+      double denominator = direction.cross(edge);
+      if (denominator == 0.0)
+        continue;
+
+      double t = offset.cross(edge) / denominator;
+      double u = offset.cross(direction) / denominator;
+      if (t > 0.0 && t < nearest && u >= 0.0 && u <= 1.0)
+        nearest = t;
+    }
+
+    for (const Circle& pillar : pillars) {
+      Vec offset = origin - pillar.center();
+      double b = offset.dot(direction);
+      double c = offset.lengthSquared() - pillar.radius() * pillar.radius();
+      double discriminant = b * b - c;
+      if (discriminant < 0.0)
+        continue;
+
+      double t = -b - sqrt(discriminant);
+      if (t <= 0.0)
+        t = -b + sqrt(discriminant);
+      if (t > 0.0 && t < nearest)
+        nearest = t;
+    }
+
+    return (nearest < max_range) ? nearest :
+           std::numeric_limits<double>::infinity();
+  }
+};
+
+/**
+ * @class WorkloadGenerator workload_generator.h
+ *
+ * @brief Deterministic generator of synthetic points and scans
+ *
+ * Samples noisy points from figures and sets of figures straight into a
+ * PointCloud2D, simulates lidar scans of a Scene by ray casting and creates
+ * typical scenes. The uniform and Gaussian variates are derived directly from
+ * std::mt19937_64 (53 bit mantissas and the Box-Muller transform), not from
+ * the implementation-defined standard distributions, hence a given seed gives
+ * the same data on every platform.
+ */
+class WorkloadGenerator
+{
+public:
+
+  /**
+   * @brief Construction with given seed (default)
+   */
+  explicit WorkloadGenerator(uint64_t seed = 1) :
+    engine_(seed),
+    has_spare_(false),
+    spare_(0.0)
+  {}
+
+  /**
+   * @brief Restart the sequence with given seed
+   */
+  void seed(uint64_t seed) {
+    engine_.seed(seed);
+    has_spare_ = false;
+  }
+
+  //
+  // Variates
+  //
+
+  /**
+   * @brief Get uniform variate from range [0, 1)
+   */
+  double uniform() {
+    return (engine_() >> 11) * 0x1.0p-53;
+  }
+
+  /**
+   * @brief Get uniform variate from range [a, b)
+   */
+  double uniform(double a, double b) {
+    return a + (b - a) * uniform();
+  }
+
+  /**
+   * @brief Get standard normal variate
+   */
+  double gaussian() {
+    if (has_spare_) {
+      has_spare_ = false;
+      return spare_;
+    }
+
+    double r = sqrt(-2.0 * log(1.0 - uniform()));
+    double phi = 2.0 * M_PI * uniform();
+    spare_ = r * sin(phi);
+    has_spare_ = true;
+    return r * cos(phi);
+  }
+
+  //
+  // Sampling of figures
+  //
+
+  /**
+   * @brief Append noisy copies of a point
+   *
+   * @param p is the point
+   * @param n is the number of samples
+   * @param noise is the noise model
+   * @param cloud is the cloud the points are appended to
+   */
+  void sample(const Point& p, size_t n, const NoiseModel& noise,
+              PointCloud2D& cloud) {
+    cloud.reserve(cloud.size() + n);
+    for (size_t i = 0; i < n; ++i)
+      addPoint(p, noise, cloud);
+  }
+
+  /**
+   * @brief Append noisy points spread uniformly along a segment
+   *
+   * @sa sample(const Point&, size_t, const NoiseModel&, PointCloud2D&)
+   */
+  void sample(const Segment& s, size_t n, const NoiseModel& noise,
+              PointCloud2D& cloud) {
+    cloud.reserve(cloud.size() + n);
+    Point start = s.startPoint();
+    Vec edge = s.endPoint() - start;
+
+    for (size_t i = 0; i < n; ++i)
+      addPoint(start + uniform() * edge, noise, cloud);
+  }
+
+  /**
+   * @brief Append noisy points spread uniformly along a circle
+   *
+   * @sa sample(const Point&, size_t, const NoiseModel&, PointCloud2D&)
+   */
+  void sample(const Circle& c, size_t n, const NoiseModel& noise,
+              PointCloud2D& cloud) {
+    sampleAngles(c.center(), c.radius(), 0.0, 2.0 * M_PI, n, noise, cloud);
+  }
+
+  /**
+   * @brief Append noisy points spread uniformly along an arc
+   *
+   * @sa sample(const Point&, size_t, const NoiseModel&, PointCloud2D&)
+   */
+  void sample(const Arc& a, size_t n, const NoiseModel& noise,
+              PointCloud2D& cloud) {
+    double sweep = (a.radius() > 0.0) ? a.length() / a.radius() : 0.0;
+    sampleAngles(a.center(), a.radius(), a.startAngle(), sweep, n, noise,
+                 cloud);
+  }
+
+  /**
+   * @brief Append noisy points spread uniformly in the parametric angle of an
+   * ellipse
+   *
+   * Note that the points are denser at the ends of the major axis.
+   *
+   * @sa sample(const Point&, size_t, const NoiseModel&, PointCloud2D&)
+   */
+  void sample(const Ellipse& e, size_t n, const NoiseModel& noise,
+              PointCloud2D& cloud) {
+    cloud.reserve(cloud.size() + n);
+    for (size_t i = 0; i < n; ++i)
+      addPoint(e.createPointFromAngle(uniform(0.0, 2.0 * M_PI)), noise,
+               cloud);
+  }
+
+  /**
+   * @brief Append noisy points spread uniformly along the boundary of a
+   * rectangle
+   *
+   * @sa sample(const Point&, size_t, const NoiseModel&, PointCloud2D&)
+   */
+  void sample(const Rectangle& r, size_t n, const NoiseModel& noise,
+              PointCloud2D& cloud) {
+    cloud.reserve(cloud.size() + n);
+    const double perimeter = 2.0 * (r.length() + r.width());
+
+    for (size_t i = 0; i < n; ++i) {
+      // Sides 0-1 and 2-3 have the length, sides 1-2 and 3-0 the width
+      double s = uniform() * perimeter;
+      int side = 0;
+      while (side < 3 && s > ((side % 2) ? r.width() : r.length())) {
+        s -= (side % 2) ? r.width() : r.length();
+        side++;
+      }
+
+      double t = s / ((side % 2) ? r.width() : r.length());
+      Point from = r.corner(side), to = r.corner(side + 1);
+      addPoint(from + std::min(t, 1.0) * (to - from), noise, cloud);
+    }
+  }
+
+  /**
+   * @brief Append noisy points sampled from any figure
+   *
+   * Projects points drawn uniformly from a square onto the figure, hence the
+   * density of points along the figure depends on its shape. Use the
+   * overloads for the particular figures for uniform densities.
+   *
+   * @param f is the figure
+   * @param center is the center of the square
+   * @param extent is the half of the side of the square
+   * @param n is the number of samples
+   * @param noise is the noise model
+   * @param cloud is the cloud the points are appended to
+   */
+  void sample(const Figure& f, const Point& center, double extent, size_t n,
+              const NoiseModel& noise, PointCloud2D& cloud) {
+    cloud.reserve(cloud.size() + n);
+    for (size_t i = 0; i < n; ++i) {
+      Point p(center.x + uniform(-extent, extent),
+              center.y + uniform(-extent, extent));
+      addPoint(f.findProjectionOf(p), noise, cloud);
+    }
+  }
+
+  /**
+   * @brief Append noisy points sampled from a set of figures
+   *
+   * Every figure gets n / figures.size() points, the first figures get one
+   * point more if n is not divisible.
+   *
+   * @param figures is the set of figures of the same type
+   * @param n is the total number of samples
+   * @param noise is the noise model
+   * @param cloud is the cloud the points are appended to
+   */
+  template <typename F>
+  void sample(const std::vector<F>& figures, size_t n, const NoiseModel& noise,
+              PointCloud2D& cloud) {
+    if (figures.empty())
+      return;
+
+    for (size_t i = 0; i < figures.size(); ++i)
+      sample(figures[i], n / figures.size() + (i < n % figures.size()),
+             noise, cloud);
+  }
+
+  //
+  // Simulated scans
+  //
+
+  /**
+   * @brief Simulate lidar scan of a scene
+   *
+   * Casts one ray per element of scan.ranges, starting at scan.angle_min
+   * relative to the heading. Beams without a return within scan.range_max
+   * get an infinite range, dropped beams get NaN and outliers get a range
+   * uniformly shorter than the true one (spurious returns).
+   *
+   * @param scene is the scene
+   * @param position is the position of the sensor
+   * @param heading is the orientation of the sensor in radians
+   * @param noise is the noise model of ranges
+   * @param scan is the scan with the geometry set, its ranges are overwritten
+   */
+  void simulateScan(const Scene& scene, const Point& position, double heading,
+                    const NoiseModel& noise, LaserScan& scan) {
+    for (size_t i = 0; i < scan.ranges.size(); ++i) {
+      double a = heading + scan.angle_min + i * scan.angle_increment;
+      double range = scene.castRay(position, Vec(cos(a), sin(a)),
+                                   scan.range_max);
+
+      if (noise.dropout_rate > 0.0 && uniform() < noise.dropout_rate)
+        range = std::numeric_limits<double>::quiet_NaN();
+      else if (std::isfinite(range)) {
+        if (noise.outlier_rate > 0.0 && uniform() < noise.outlier_rate)
+          range = uniform(scan.range_min, range);
+        else if (noise.sigma > 0.0 || noise.range_sigma > 0.0)
+          range += gaussian() * (noise.sigma + noise.range_sigma * range);
+      }
+
+      scan.ranges[i] = range;
+    }
+  }
+
+  //
+  // Scenes
+  //
+
+  /**
+   * @brief Create straight corridor along x axis, starting at (0, 0)
+   *
+   * @param length is the length of the corridor
+   * @param width is the width of the corridor
+   * @param spacing is the distance between door recesses on both sides
+   */
+  Scene createCorridor(double length = 100.0, double width = 3.0,
+                       double spacing = 6.0) {
+    Scene scene;
+    const double door = std::min(1.0, spacing / 2.0);
+
+    for (double x = 0.0; x < length; x += spacing) {
+      scene.walls.emplace_back(Point(x, 0.0),
+                               Point(x + spacing - door, 0.0));
+      scene.walls.emplace_back(Point(x, width),
+                               Point(x + spacing - door, width));
+      scene.addBox(x + spacing - door, -0.3, x + spacing, 0.0);
+      scene.addBox(x + spacing - door, width, x + spacing, width + 0.3);
+    }
+
+    return scene;
+  }
+
+  /**
+   * @brief Create square hall centered at (0, 0) with a jittered grid of
+   * pillars of random radii
+   *
+   * @param size is the side of the hall
+   * @param spacing is the spacing of the grid of pillars
+   */
+  Scene createPillars(double size = 40.0, double spacing = 3.0) {
+    Scene scene;
+    const double half = size / 2.0;
+
+    scene.addBox(-half, -half, half, half);
+    for (double x = -half + spacing / 2.0; x < half; x += spacing)
+      for (double y = -half + spacing / 2.0; y < half; y += spacing)
+        if (std::abs(x) > spacing || std::abs(y) > spacing)
+          scene.pillars.emplace_back(
+            Point(x + uniform(-0.5, 0.5), y + uniform(-0.5, 0.5)),
+            uniform(0.15, 0.5));
+
+    return scene;
+  }
+
+  /**
+   * @brief Create square room centered at (0, 0) filled with randomly placed
+   * short walls and small round objects
+   *
+   * @param size is the side of the room
+   * @param objects is the number of objects
+   */
+  Scene createClutter(double size = 30.0, size_t objects = 200) {
+    Scene scene;
+    const double half = size / 2.0;
+
+    scene.addBox(-half, -half, half, half);
+    for (size_t i = 0; i < objects; ++i) {
+      Point p(uniform(-half + 1.0, half - 1.0),
+              uniform(-half + 1.0, half - 1.0));
+      if (p.length() < 1.5)
+        continue;
+
+      if (i % 2 == 0)
+        scene.walls.emplace_back(p, p + uniform(0.1, 1.5) *
+                                        Vec(1.0, 0.0).rotated(
+                                          uniform(-M_PI, M_PI)));
+      else
+        scene.pillars.emplace_back(p, uniform(0.02, 0.3));
+    }
+
+    return scene;
+  }
+
+private:
+
+  /**
+   * @brief Append noisy points spread uniformly in angle along circle
+   */
+  void sampleAngles(const Point& center, double radius, double start,
+                    double sweep, size_t n, const NoiseModel& noise,
+                    PointCloud2D& cloud) {
+    cloud.reserve(cloud.size() + n);
+    for (size_t i = 0; i < n; ++i) {
+      double a = start + sweep * uniform();
+      addPoint(Point(center.x + radius * cos(a), center.y + radius * sin(a)),
+               noise, cloud);
+    }
+  }
+
+  /**
+   * @brief Append point after applying noise model
+   */
+  void addPoint(const Point& p, const NoiseModel& noise, PointCloud2D& cloud) {
+    if (noise.dropout_rate > 0.0 && uniform() < noise.dropout_rate)
+      return;
+
+    if (noise.outlier_rate > 0.0 && uniform() < noise.outlier_rate) {
+      cloud.push_back(p.x + uniform(-1.0, 1.0) * noise.outlier_spread,
+                      p.y + uniform(-1.0, 1.0) * noise.outlier_spread);
+      return;
+    }
+
+    double sigma = noise.sigma;
+    if (noise.range_sigma > 0.0)
+      sigma += noise.range_sigma * (p - noise.sensor).length();
+
+    if (sigma > 0.0)
+      cloud.push_back(p.x + sigma * gaussian(), p.y + sigma * gaussian());
+    else
+      cloud.push_back(p.x, p.y);
+  }
+
+  std::mt19937_64 engine_;  /**< @brief Engine of random bits */
+  bool has_spare_;          /**< @brief Flag of cached normal variate */
+  double spare_;            /**< @brief Cached normal variate */
+};
+
+} // end namespace figfit